@@ -0,0 +1,89 @@
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+/**
+ * Common helpers of the sysfs micro benchmarks.
+ *
+ * Each strategy is run for a fixed number of iterations and reports the
+ * time per operation and the number of syscalls per operation.
+ *
+ * The syscalls are counted by the kernel in `/proc/self/io` (`syscr` and
+ * `syscw`).
+ * Note, these counters only cover the read and write family (`read`,
+ * `pread`, `readv`, `write`, `pwrite`, ...), but neither `lseek`, `open`,
+ * `close` nor `io_uring_enter`; the description of each strategy lists
+ * the uncounted syscalls.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace Benchmark {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Result {
+	double nsPerOp;
+	double syscallsPerOp;
+};
+
+/**
+ * Returns the number of read and write syscalls of this process so far.
+ *
+ * The call itself issues one `pread` which is only accounted for by the
+ * next call.
+ */
+inline unsigned long long getSyscallCount() {
+	static int const fd = open( "/proc/self/io", O_RDONLY | O_CLOEXEC );
+	char buffer[512];
+	ssize_t const n = fd == -1 ? -1 : pread( fd, buffer, sizeof( buffer ) - 1, 0 );
+	if( n <= 0 ) return 0;
+	buffer[n] = '\0';
+	char const* const syscr = std::strstr( buffer, "syscr: " );
+	char const* const syscw = std::strstr( buffer, "syscw: " );
+	if( syscr == nullptr || syscw == nullptr ) return 0;
+	return std::strtoull( syscr + 7, nullptr, 10 ) + std::strtoull( syscw + 7, nullptr, 10 );
+}
+
+/**
+ * Runs `op` `n` times.
+ */
+template<typename Op> Result run( unsigned long const n, Op&& op ) {
+	unsigned long long const syscallsBefore = getSyscallCount();
+	Clock::time_point const start = Clock::now();
+	for( unsigned long i = 0; i != n; i++ ) op( i );
+	Clock::time_point const stop = Clock::now();
+	// Subtract the `pread` of the first `getSyscallCount`
+	unsigned long long const syscalls = getSyscallCount() - syscallsBefore - 1;
+	return Result{
+		std::chrono::duration<double, std::nano>( stop - start ).count() / n,
+		static_cast<double>( syscalls ) / n
+	};
+}
+
+inline void printHeader( std::string const& path, bool const isFake, unsigned long const n ) {
+	std::cout << "file:       " << path << ( isFake ? " (tmpfs fake)" : "" ) << '\n'
+	          << "iterations: " << n << '\n'
+	          << std::left << std::setw( 32 ) << "strategy"
+	          << std::right << std::setw( 12 ) << "ns/op"
+	          << std::setw( 14 ) << "syscalls/op" << '\n';
+}
+
+inline void printResult( char const* strategy, Result const& r ) {
+	std::cout << std::left << std::setw( 32 ) << strategy
+	          << std::right << std::fixed
+	          << std::setw( 12 ) << std::setprecision( 1 ) << r.nsPerOp
+	          << std::setw( 14 ) << std::setprecision( 2 ) << r.syscallsPerOp << '\n'
+	          << std::defaultfloat;
+}
+
+}
+
+#endif
@@ -0,0 +1,184 @@
+/**
+ * Benchmarks the parser of the configuration.
+ *
+ * The input is a synthetic configuration with global settings, sensors and
+ * actuators and a number of controllers which set every controller
+ * attribute, interspersed with comments and empty lines.
+ *
+ * Strategies:
+ *  - `regex lexer`: the former lexer of `ConfigLine` with two `std::regex`
+ *    matches per line
+ *  - `ConfigLine`: the single-pass lexer
+ *  - `compare chain`: the former dispatch of the attribute, i.e. a linear
+ *    chain of string comparisons in the order of `loadAttribute` (on the
+ *    lexed lines)
+ *  - `PerfectHash`: the dispatch of the attribute by the perfect hash table
+ *    (on the lexed lines)
+ *  - `loadFromStream`: the production path including the conversion of the
+ *    values
+ *
+ * Usage: amdgpu-config-bench [<iterations> [<controllers>]]
+ */
+
+#include "logger2.h"
+#include "perfect_hash.h"
+#include "regex-config-line.h"
+#include "runtime_config.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace AmdGpuFanControl;
+
+typedef std::chrono::steady_clock Clock;
+typedef RuntimeConfig::ControllerConfig ControllerConfig;
+
+/**
+ * All attributes in the order in which the former `loadAttribute` and
+ * `loadControllerAttribute` compared them.
+ */
+static char const* const ATTRIBUTES[] = {
+	RuntimeConfig::LOG_TRESHOLD_ATTRIBUTE,
+	RuntimeConfig::LOG_ASYNCHRONOUS_ATTRIBUTE,
+	RuntimeConfig::CONTROL_INTERVAL_ATTRIBUTE,
+	RuntimeConfig::MAX_CONTROL_INTERVAL_ATTRIBUTE,
+	RuntimeConfig::TEMPERATURE_ALARM_WAKEUP_ATTRIBUTE,
+	RuntimeConfig::TELEMETRY_FILE_PATH_ATTRIBUTE,
+	RuntimeConfig::TELEMETRY_RECORD_COUNT_ATTRIBUTE,
+	RuntimeConfig::METRICS_SOCKET_PATH_ATTRIBUTE,
+	RuntimeConfig::HWMON_CACHE_FILE_PATH_ATTRIBUTE,
+	RuntimeConfig::TEMPERATURE_SENSOR_PATH_ATTRIBUTE,
+	RuntimeConfig::PWM_ACTUATOR_PATH_ATTRIBUTE,
+	ControllerConfig::CONTROL_CURVE_ATTRIBUTE,
+	ControllerConfig::CONTROL_MODE_ATTRIBUTE,
+	ControllerConfig::TEMPERATURE_FILTER_ATTRIBUTE,
+	ControllerConfig::TEMPERATURE_SENSOR_INDEX_ATTRIBUTE,
+	ControllerConfig::TEMPERATURE_AGGREGATION_ATTRIBUTE,
+	ControllerConfig::TEMPERATURE_SENSOR_WEIGHTS_ATTRIBUTE,
+	ControllerConfig::TEMPERATURE_SENSOR_LIMITS_ATTRIBUTE,
+	ControllerConfig::PID_PROPORTIONAL_GAIN_ATTRIBUTE,
+	ControllerConfig::PID_INTEGRAL_GAIN_ATTRIBUTE,
+	ControllerConfig::PID_DERIVATIVE_GAIN_ATTRIBUTE,
+	ControllerConfig::PWM_ACTUATOR_INDEX_ATTRIBUTE,
+	ControllerConfig::UPWARD_TEMPERATURE_HYSTERESIS_ATTRIBUTE,
+	ControllerConfig::DOWNWARD_TEMPERATURE_HYSTERESIS_ATTRIBUTE,
+	ControllerConfig::BASE_CONTROL_TEMPERATURE_ATTRIBUTE,
+	ControllerConfig::BASE_CONTROL_PWM_ATTRIBUTE,
+	ControllerConfig::MIN_CONTROL_TEMPERATURE_ATTRIBUTE,
+	ControllerConfig::MIN_CONTROL_PWM_ATTRIBUTE,
+	ControllerConfig::MAX_CONTROL_TEMPERATURE_ATTRIBUTE,
+	ControllerConfig::MAX_CONTROL_PWM_ATTRIBUTE,
+	ControllerConfig::PID_TARGET_TEMPERATURE_ATTRIBUTE,
+	ControllerConfig::PID_SLEW_RATE_ATTRIBUTE,
+	ControllerConfig::PID_OUTPUT_HYSTERESIS_ATTRIBUTE,
+	ControllerConfig::TEMPERATURE_FILTER_WINDOW_ATTRIBUTE,
+	ControllerConfig::TEMPERATURE_FILTER_EMA_SHIFT_ATTRIBUTE,
+};
+static constexpr std::size_t ATTRIBUTE_COUNT = std::size( ATTRIBUTES );
+
+static std::vector<std::string> createConfig( unsigned long const controllers ) {
+	std::vector<std::string> lines( {
+		"# Synthetic configuration",
+		"CONTROL_INTERVAL = 1000",
+		"MAX_CONTROL_INTERVAL = 4000",
+		"TEMPERATURE_ALARM_WAKEUP = 1",
+		"",
+	} );
+	for( unsigned long i = 0; i != controllers; i++ ) {
+		std::string const idx( "." + std::to_string( i ) );
+		lines.push_back( "# Controller " + std::to_string( i ) );
+		lines.push_back( "TEMPERATURE_SENSOR_PATH" + idx + " = hwmon://0000:03:00.0/temp1_input" );
+		lines.push_back( "PWM_ACTUATOR_PATH" + idx + " = hwmon://0000:03:00.0/pwm1" );
+		lines.push_back( "  TEMPERATURE_SENSOR_INDEX" + idx + " = " + std::to_string( i ) );
+		lines.push_back( "PWM_ACTUATOR_INDEX" + idx + " = " + std::to_string( i ) );
+		lines.push_back( "UPWARD_TEMPERATURE_HYSTERESIS" + idx + " = 500" );
+		lines.push_back( "DOWNWARD_TEMPERATURE_HYSTERESIS" + idx + " = 3000" );
+		lines.push_back( "CONTROL_CURVE" + idx + " = 45000:57 60000:100 95000:255" );
+		lines.push_back( "CONTROL_MODE" + idx + " = PID" );
+		lines.push_back( "PID_TARGET_TEMPERATURE" + idx + " = 70000" );
+		lines.push_back( "PID_PROPORTIONAL_GAIN" + idx + " = 8.0" );
+		lines.push_back( "PID_INTEGRAL_GAIN" + idx + " = 0.5" );
+		lines.push_back( "PID_SLEW_RATE" + idx + " = 10" );
+		lines.push_back( "TEMPERATURE_FILTER" + idx + " = MEDIAN" );
+		lines.push_back( "TEMPERATURE_FILTER_EMA_SHIFT" + idx + "\t=\t2\t" );
+		lines.push_back( "" );
+	}
+	return lines;
+}
+
+template<typename Op> static double run( unsigned long const n, std::size_t const lineCount, Op&& op ) {
+	Clock::time_point const start = Clock::now();
+	for( unsigned long i = 0; i != n; i++ ) op();
+	Clock::time_point const stop = Clock::now();
+	return std::chrono::duration<double, std::nano>( stop - start ).count() / n / lineCount;
+}
+
+static void printResult( char const* strategy, double const nsPerLine ) {
+	std::cout << std::left << std::setw( 20 ) << strategy
+	          << std::right << std::setw( 12 ) << std::fixed << std::setprecision( 1 ) << nsPerLine
+	          << std::setw( 16 ) << std::setprecision( 2 ) << 1000.0 / nsPerLine << '\n';
+}
+
+int main( int argc, char** argv ) {
+	unsigned long const n = argc > 1 ? std::strtoul( argv[1], nullptr, 10 ) : 100;
+	unsigned long const controllers = argc > 2 ? std::strtoul( argv[2], nullptr, 10 ) : 64;
+	if( controllers > RuntimeConfig::MAX_INDEX + 1 ) {
+		std::cerr << "At most " << RuntimeConfig::MAX_INDEX + 1 << " controllers" << std::endl;
+		return 1;
+	}
+	LogStream::get().setTreshold( LogBuffer::Severity::EMERGENCY );
+
+	std::vector<std::string> const lines( createConfig( controllers ) );
+	std::string text;
+	for( std::string const& line : lines ) text += line + '\n';
+	std::vector<RuntimeConfig::ConfigLine> configLines;
+	for( std::string const& line : lines ) configLines.emplace_back( line );
+
+	PerfectHash<ATTRIBUTE_COUNT>::KeySeq keys;
+	for( std::size_t i = 0; i != ATTRIBUTE_COUNT; i++ ) keys[i] = ATTRIBUTES[i];
+	PerfectHash<ATTRIBUTE_COUNT> const table( keys );
+
+	std::cout << "lines:      " << lines.size() << " (" << text.size() << " bytes)\n"
+	          << "iterations: " << n << '\n'
+	          << std::left << std::setw( 20 ) << "strategy"
+	          << std::right << std::setw( 12 ) << "ns/line"
+	          << std::setw( 16 ) << "Mlines/s" << '\n';
+
+	// Accumulated results keep the compiler from eliding the work
+	std::size_t sink = 0;
+	printResult( "regex lexer", run( n, lines.size(), [&] {
+		for( std::string const& line : lines ) sink += RegexConfigLine( line ).valid;
+	} ) );
+	printResult( "ConfigLine", run( n, lines.size(), [&] {
+		for( std::string const& line : lines ) sink += RuntimeConfig::ConfigLine( line ).isValid();
+	} ) );
+	printResult( "compare chain", run( n, lines.size(), [&] {
+		for( RuntimeConfig::ConfigLine const& configLine : configLines ) {
+			if( !configLine.isValid() ) continue;
+			std::size_t i = 0;
+			while( i != ATTRIBUTE_COUNT && configLine.getAttribute().compare( ATTRIBUTES[i] ) != 0 ) i++;
+			sink += i;
+		}
+	} ) );
+	printResult( "PerfectHash", run( n, lines.size(), [&] {
+		for( RuntimeConfig::ConfigLine const& configLine : configLines ) {
+			if( !configLine.isValid() ) continue;
+			sink += table.find( configLine.getAttribute() );
+		}
+	} ) );
+	printResult( "loadFromStream", run( n, lines.size(), [&] {
+		RuntimeConfig config;
+		std::istringstream stream( text );
+		config.loadFromStream( stream );
+		sink += config.getControllerConfigSeq().size();
+	} ) );
+	std::cout << "(checksum " << sink << ")" << std::endl;
+	return 0;
+}
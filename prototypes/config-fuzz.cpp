@@ -0,0 +1,174 @@
+/**
+ * Fuzz harness of the configuration parser.
+ *
+ * Each input is split into lines and every line is checked against the
+ * following invariants:
+ *  - a line is never both valid and failed
+ *  - a failed line reports a column within the line (or just behind it) and
+ *    a message
+ *  - a valid line has a non-empty attribute of letters and underscores and
+ *    a non-empty value without white space at either end
+ *  - a valid line which is written as `ATTRIBUTE[.index] = value` and parsed
+ *    again yields the same attribute, index and value
+ *  - `ConfigLine` agrees with the former regex-based lexer on every line
+ * Finally, the entire input is loaded by `RuntimeConfig::loadFromStream`,
+ * which must neither crash nor throw.
+ *
+ * Usage: amdgpu-config-fuzz [<iterations> [<seed>]]
+ *
+ * The standalone driver mutates a small corpus of valid lines (random
+ * insertions, deletions and replacements of bytes from an alphabet of
+ * characters which are significant for the grammar, splices of attribute
+ * names, overlong indices) and aborts with the offending input on the first
+ * violation.
+ * The harness also provides the libFuzzer entry point; to use libFuzzer
+ * instead of the standalone driver, compile with
+ * `clang++ -std=c++17 -DAMDGPU_FANCTRL_LIBFUZZER -fsanitize=fuzzer,address`.
+ */
+
+#include "logger2.h"
+#include "regex-config-line.h"
+#include "runtime_config.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace AmdGpuFanControl;
+
+static void check( bool const condition, char const* const invariant, std::string const& line ) {
+	if( condition ) return;
+	std::cerr << "Violated invariant: " << invariant << "\nLine: \"" << line << "\"" << std::endl;
+	std::abort();
+}
+
+static bool isSpace( char const c ) {
+	return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+static void checkLine( std::string const& line ) {
+	RuntimeConfig::ConfigLine const configLine( line );
+	check( !( configLine.isValid() && configLine.hasFailed() ), "valid and failed", line );
+
+	if( configLine.hasFailed() ) {
+		check( configLine.getErrorColumn() >= 1 && configLine.getErrorColumn() <= line.size() + 1, "error column", line );
+		check( configLine.getErrorMessage() != nullptr, "error message", line );
+	}
+
+	if( configLine.isValid() ) {
+		std::string const& attribute( configLine.getAttribute() );
+		std::string const& value( configLine.getValue() );
+		check( !attribute.empty(), "non-empty attribute", line );
+		check( attribute.find_first_not_of( "_ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz" ) == std::string::npos, "attribute characters", line );
+		check( !value.empty() && !isSpace( value.front() ) && !isSpace( value.back() ), "trimmed value", line );
+		check( !configLine.hasIndex() || configLine.getIndex() <= RuntimeConfig::MAX_INDEX + 1, "saturated index", line );
+
+		std::string const written(
+			attribute + ( configLine.hasIndex() ? "." + std::to_string( configLine.getIndex() ) : "" ) + " = " + value
+		);
+		RuntimeConfig::ConfigLine const reparsed( written );
+		check(
+			reparsed.isValid() && reparsed.getAttribute() == attribute &&
+			reparsed.getIndex() == configLine.getIndex() && reparsed.getValue() == value,
+			"round trip", line
+		);
+	}
+
+	RegexConfigLine const reference( line );
+	check(
+		reference.valid == configLine.isValid() && reference.failed == configLine.hasFailed() &&
+		reference.attribute == configLine.getAttribute() && reference.index == configLine.getIndex() &&
+		reference.value == configLine.getValue(),
+		"agreement with regex lexer", line
+	);
+}
+
+extern "C" int LLVMFuzzerTestOneInput( std::uint8_t const* data, std::size_t size ) {
+	std::string const input( reinterpret_cast<char const*>( data ), size );
+	std::istringstream lines( input );
+	for( std::string line; std::getline( lines, line ); )
+		checkLine( line );
+
+	RuntimeConfig config;
+	std::istringstream stream( input );
+	config.loadFromStream( stream );
+	return 0;
+}
+
+#ifndef AMDGPU_FANCTRL_LIBFUZZER
+
+static char const* const CORPUS[] = {
+	"CONTROL_INTERVAL = 1000",
+	"  MAX_CONTROL_INTERVAL=4000  ",
+	"TEMPERATURE_SENSOR_PATH.0 = /sys/class/hwmon/hwmon0/temp1_input",
+	"PWM_ACTUATOR_PATH.1 = hwmon://0000:03:00.0/pwm1",
+	"TEMPERATURE_SENSOR_INDEX.2 = 0 1, 2",
+	"CONTROL_CURVE.1 = 45000:57 60000:100 95000:255",
+	"CONTROL_MODE = PID",
+	"PID_PROPORTIONAL_GAIN.3 = 8.5",
+	"TEMPERATURE_FILTER = MEDIAN_EMA",
+	"LOG_TRESHOLD = WARNING",
+	"# comment = value",
+	"",
+	"\t\r",
+	"NAME = John Dear",
+	"UNKNOWN_ATTRIBUTE.7 = 12",
+};
+
+static char const ALPHABET[] = " \t\r\v=.#_:,-09AZaz\xff";
+
+static std::string mutate( std::string line, std::mt19937& random ) {
+	std::uniform_int_distribution<unsigned> operation( 0, 5 );
+	std::uniform_int_distribution<std::size_t> character( 0, sizeof( ALPHABET ) - 2 );
+	unsigned const count = 1 + random() % 4;
+	for( unsigned i = 0; i != count; i++ ) {
+		std::size_t const pos = line.empty() ? 0 : random() % ( line.size() + 1 );
+		switch( operation( random ) ) {
+			case 0:
+				line.insert( pos, 1, ALPHABET[character( random )] );
+				break;
+			case 1:
+				if( pos < line.size() ) line.erase( pos, 1 );
+				break;
+			case 2:
+				if( pos < line.size() ) line[pos] = ALPHABET[character( random )];
+				break;
+			case 3:
+				line.insert( pos, 1, static_cast<char>( random() ) );
+				break;
+			case 4:
+				line.insert( pos, CORPUS[random() % std::size( CORPUS )] );
+				break;
+			case 5:
+				line.insert( pos, "." + std::to_string( random() ) + std::to_string( random() ) );
+				break;
+		}
+	}
+	return line;
+}
+
+int main( int argc, char** argv ) {
+	unsigned long const n = argc > 1 ? std::strtoul( argv[1], nullptr, 10 ) : 100000;
+	unsigned long const seed = argc > 2 ? std::strtoul( argv[2], nullptr, 10 ) : 1;
+	std::mt19937 random( seed );
+	LogStream::get().setTreshold( LogBuffer::Severity::EMERGENCY );
+
+	for( unsigned long i = 0; i != n; i++ ) {
+		std::string input;
+		unsigned const lineCount = 1 + random() % 8;
+		for( unsigned l = 0; l != lineCount; l++ ) {
+			std::string const line( CORPUS[random() % std::size( CORPUS )] );
+			input += ( random() % 4 == 0 ? line : mutate( line, random ) ) + '\n';
+		}
+		LLVMFuzzerTestOneInput( reinterpret_cast<std::uint8_t const*>( input.data() ), input.size() );
+	}
+	std::cout << n << " inputs without violation (seed " << seed << ")" << std::endl;
+	return 0;
+}
+
+#endif
@@ -0,0 +1,364 @@
+/**
+ * Runs the unmodified control loop against a simulated hwmon device.
+ *
+ * The simulator creates a fake hwmon directory on tmpfs (`/dev/shm`) with
+ * `temp1_input`, `pwm1`, `pwm1_enable` and `fan1_input` and runs
+ * `PWMControllers` against it.
+ * A background thread integrates a lumped thermal model: the GPU is a
+ * single heat capacity which is heated by a scripted load and cooled
+ * towards the ambient temperature by a thermal conductance which grows with
+ * the fan speed.
+ * The fan speed follows the PWM value written by the daemon with a lag.
+ *
+ * The simulation runs faster than real time: simulated time passes
+ * `<speed-up>` times faster than real time and the control interval of the
+ * daemon is scaled down by the same factor.
+ *
+ * The load profile is a text file with one segment per line, each of which
+ * consists of the duration in (simulated) seconds and the heat load in W,
+ * e.g.
+ *
+ *     600 15
+ *     1200 220
+ *
+ * Without a profile, a built-in profile of one simulated hour is used.
+ *
+ * Additional daemon settings (e.g. the control curve) can be passed as
+ * a configuration file; `CONTROL_INTERVAL` and `MAX_CONTROL_INTERVAL` as
+ * well as the time-dependent settings of the PID mode are given in
+ * simulated time and scaled by the simulator.
+ *
+ * For each segment of the profile the simulator reports the settling time
+ * (until the temperature finally stays within `SETTLING_BAND` of its
+ * value at the end of the segment) and the overshoot beyond that value.
+ * Finally, it reports the number of actuator writes and the CPU time of the
+ * control loop per simulated hour.
+ *
+ * Optionally, the readings jitter uniformly by up to `<noise>` °C around
+ * the modelled temperature like the junction temperature of real devices.
+ *
+ * Usage: amdgpu-hwmon-sim [-s <speed-up>] [-p <profile>] [-c <config>]
+ *                         [-t <trace.csv>] [-n <noise>] [-d]
+ */
+
+#include "logger2.h"
+#include "pwm_actuator.h"
+#include "pwm_actuator_factory.h"
+#include "pwm_controllers.h"
+#include "runtime_config.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace AmdGpuFanControl;
+
+typedef std::chrono::steady_clock Clock;
+
+struct Segment {
+	double duration;  ///< s
+	double load;  ///< W
+};
+typedef std::vector<Segment> Profile;
+
+/**
+ * Parameters of the thermal model.
+ */
+struct Model {
+	double ambient = 30.0;  ///< °C
+	double capacity = 300.0;  ///< J/K
+	double passiveConductance = 1.0;  ///< W/K without fan
+	double fanConductance = 4.0;  ///< additional W/K at full fan speed
+	double fanLag = 2.0;  ///< time constant of the fan in s
+	double maxRpm = 3300.0;
+	PwmValue minSpinningPwm = 20;  ///< the fan stalls below this PWM value
+	double sensorNoise = 0.0;  ///< amplitude of the jitter of readings in °C
+};
+
+/**
+ * State of the simulation at the end of a profile segment.
+ */
+struct SegmentResult {
+	double startTemperature;
+	double endTemperature;
+	double minTemperature;
+	double maxTemperature;
+	double lastOutsideBand;  ///< s after the start of the segment
+};
+
+static double const SETTLING_BAND = 1.0;  // °C
+static double const SIMULATION_STEP = 0.01;  // s
+
+static Profile const DEFAULT_PROFILE = {
+	{ 600.0, 15.0 },
+	{ 1200.0, 220.0 },
+	{ 600.0, 80.0 },
+	{ 1200.0, 15.0 }
+};
+
+static void writeValue( int const fd, long const value ) {
+	std::string const s( std::to_string( value ) + "\n" );
+	if( pwrite( fd, s.data(), s.size(), 0 ) == -1 || ftruncate( fd, s.size() ) == -1 )
+		std::cerr << "Cannot update simulated hwmon file" << std::endl;
+}
+
+/**
+ * Reads the PWM value written by the daemon.
+ *
+ * Only the first line is parsed as the daemon overwrites the file in place
+ * and a shorter value leaves trailing characters of the previous one on
+ * tmpfs (other than on sysfs).
+ */
+static PwmValue readPwmValue( int const fd ) {
+	char buffer[16] = {};
+	if( pread( fd, buffer, sizeof( buffer ) - 1, 0 ) <= 0 ) return 0;
+	return std::min( std::strtoul( buffer, nullptr, 10 ), 255ul );
+}
+
+static Profile loadProfile( std::string const& path ) {
+	Profile profile;
+	std::ifstream file( path );
+	if( !file.is_open() ) throw std::runtime_error( "Cannot open profile " + path );
+	for( std::string line; std::getline( file, line ); ) {
+		std::istringstream fields( line );
+		Segment s;
+		if( line.empty() || line[0] == '#' ) continue;
+		if( !( fields >> s.duration >> s.load ) || s.duration <= 0.0 )
+			throw std::runtime_error( "Invalid profile line: " + line );
+		profile.push_back( s );
+	}
+	if( profile.empty() ) throw std::runtime_error( "Empty profile " + path );
+	return profile;
+}
+
+/**
+ * Writes the daemon configuration for the fake device.
+ *
+ * Intervals and the time-dependent settings of the PID mode (given per
+ * second) of the additional configuration are scaled to real time.
+ * The defaults of the latter are scaled, too, as the PID mode measures the
+ * time between cycles in real time.
+ */
+static void writeConfig( std::string const& path, std::string const& dir, std::string const& extraConfig, double const speedUp ) {
+	typedef RuntimeConfig::ControllerConfig ControllerConfig;
+	auto scale = [speedUp]( unsigned long const ms ) {
+		return std::max( 1ul, static_cast<unsigned long>( std::lround( ms / speedUp ) ) );
+	};
+	std::ofstream config( path );
+	config << RuntimeConfig::TEMPERATURE_SENSOR_PATH_ATTRIBUTE << " = " << dir << "/temp1_input\n"
+	       << RuntimeConfig::PWM_ACTUATOR_PATH_ATTRIBUTE << " = " << dir << "/pwm1\n"
+	       << RuntimeConfig::CONTROL_INTERVAL_ATTRIBUTE << " = "
+	       << scale( RuntimeConfig::CONTROL_INTERVAL_DEFAULT_VALUE.count() ) << '\n'
+	       << ControllerConfig::PID_INTEGRAL_GAIN_ATTRIBUTE << " = "
+	       << ControllerConfig::PID_INTEGRAL_GAIN_DEFAULT_VALUE * speedUp << '\n'
+	       << ControllerConfig::PID_DERIVATIVE_GAIN_ATTRIBUTE << " = "
+	       << ControllerConfig::PID_DERIVATIVE_GAIN_DEFAULT_VALUE / speedUp << '\n'
+	       << ControllerConfig::PID_SLEW_RATE_ATTRIBUTE << " = "
+	       << std::lround( ControllerConfig::PID_SLEW_RATE_DEFAULT_VALUE * speedUp ) << '\n';
+	if( extraConfig.empty() ) return;
+
+	std::ifstream extra( extraConfig );
+	if( !extra.is_open() ) throw std::runtime_error( "Cannot open configuration " + extraConfig );
+	for( std::string line; std::getline( extra, line ); ) {
+		std::istringstream fields( line );
+		std::string attribute, equals;
+		double value;
+		fields >> attribute >> equals >> value;
+		// Strip the suffix ".<number>" of the attribute for the comparison
+		std::string const name( attribute.substr( 0, attribute.find( '.' ) ) );
+		if( !fields || equals != "=" ) {
+			config << line << '\n';
+		} else if(
+			name == RuntimeConfig::CONTROL_INTERVAL_ATTRIBUTE ||
+			name == RuntimeConfig::MAX_CONTROL_INTERVAL_ATTRIBUTE
+		) {
+			config << attribute << " = " << scale( value ) << '\n';
+		} else if( name == ControllerConfig::PID_INTEGRAL_GAIN_ATTRIBUTE ) {
+			config << attribute << " = " << value * speedUp << '\n';
+		} else if( name == ControllerConfig::PID_DERIVATIVE_GAIN_ATTRIBUTE ) {
+			config << attribute << " = " << value / speedUp << '\n';
+		} else if( name == ControllerConfig::PID_SLEW_RATE_ATTRIBUTE ) {
+			config << attribute << " = " << std::lround( value * speedUp ) << '\n';
+		} else {
+			config << line << '\n';
+		}
+	}
+}
+
+/**
+ * Integrates the thermal model until the end of the profile.
+ *
+ * The simulated time is derived from the real time since the start, such
+ * that jitter of this thread does not distort the time base.
+ * Once the profile has ended, the control loop is stopped.
+ */
+static void simulate(
+	Model const& model, Profile const& profile, double const speedUp,
+	std::string const& dir, std::string const& tracePath,
+	std::vector<SegmentResult>& results
+) {
+	int const tempFd = open( ( dir + "/temp1_input" ).c_str(), O_WRONLY | O_CLOEXEC );
+	int const fanFd = open( ( dir + "/fan1_input" ).c_str(), O_WRONLY | O_CLOEXEC );
+	int const pwmFd = open( ( dir + "/pwm1" ).c_str(), O_RDONLY | O_CLOEXEC );
+	std::ofstream trace;
+	if( !tracePath.empty() ) {
+		trace.open( tracePath );
+		trace << "time,load,temperature,pwm,rpm\n";
+	}
+
+	double temperature = model.ambient + profile.front().load / model.passiveConductance;
+	double rpm = 0.0;
+	double time = 0.0;
+	double nextTrace = 0.0;
+	// Fixed seed such that runs are comparable
+	std::mt19937 random( 1 );
+	std::uniform_real_distribution<double> noise( -model.sensorNoise, model.sensorNoise );
+	Clock::time_point const start = Clock::now();
+	for( Segment const& segment : profile ) {
+		SegmentResult r{ temperature, temperature, temperature, temperature, 0.0 };
+		std::vector<std::pair<double, double>> samples;
+		double const segmentStart = time;
+		double const segmentEnd = time + segment.duration;
+		while( time < segmentEnd ) {
+			std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+			double const target = std::min( segmentEnd,
+				std::chrono::duration<double>( Clock::now() - start ).count() * speedUp
+			);
+			PwmValue const pwm = readPwmValue( pwmFd );
+			double const targetRpm = pwm < model.minSpinningPwm ? 0.0 : model.maxRpm * pwm / 255.0;
+			for( ; time < target; time += SIMULATION_STEP ) {
+				rpm += ( targetRpm - rpm ) * SIMULATION_STEP / model.fanLag;
+				double const conductance = model.passiveConductance + model.fanConductance * rpm / model.maxRpm;
+				temperature += ( segment.load - conductance * ( temperature - model.ambient ) ) * SIMULATION_STEP / model.capacity;
+				samples.emplace_back( time - segmentStart, temperature );
+				if( trace.is_open() && time >= nextTrace ) {
+					trace << time << ',' << segment.load << ',' << temperature << ',' << pwm << ',' << rpm << '\n';
+					nextTrace += 1.0;
+				}
+			}
+			writeValue( tempFd, std::lround( ( temperature + noise( random ) ) * 1000.0 ) );
+			writeValue( fanFd, std::lround( rpm ) );
+		}
+
+		r.endTemperature = temperature;
+		for( auto const& sample : samples ) {
+			r.minTemperature = std::min( r.minTemperature, sample.second );
+			r.maxTemperature = std::max( r.maxTemperature, sample.second );
+			if( std::fabs( sample.second - r.endTemperature ) > SETTLING_BAND )
+				r.lastOutsideBand = sample.first;
+		}
+		results.push_back( r );
+	}
+
+	close( tempFd );
+	close( fanFd );
+	close( pwmFd );
+	kill( getpid(), SIGTERM );
+}
+
+static void report( Profile const& profile, std::vector<SegmentResult> const& results ) {
+	std::cout << std::fixed << std::setprecision( 1 )
+	          << "segment  duration/s  load/W  start/°C  end/°C  settling/s  overshoot/°C\n";
+	for( std::size_t i = 0; i != results.size(); i++ ) {
+		SegmentResult const& r( results[i] );
+		bool const isRising = r.endTemperature >= r.startTemperature;
+		double const overshoot = isRising ?
+			r.maxTemperature - r.endTemperature :
+			r.endTemperature - r.minTemperature;
+		std::cout << std::setw( 7 ) << i
+		          << std::setw( 12 ) << profile[i].duration
+		          << std::setw( 8 ) << profile[i].load
+		          << std::setw( 10 ) << r.startTemperature
+		          << std::setw( 8 ) << r.endTemperature
+		          << std::setw( 12 ) << r.lastOutsideBand
+		          << std::setw( 14 ) << overshoot << '\n';
+	}
+}
+
+int main( int argc, char* argv[] ) {
+	double speedUp = 100.0;
+	Profile profile( DEFAULT_PROFILE );
+	std::string extraConfig, tracePath;
+	Model model;
+	LogStream::get().setTreshold( LogBuffer::Severity::WARNING );
+	for( int opt; ( opt = getopt( argc, argv, "s:p:c:t:n:d" ) ) != -1; ) {
+		switch( opt ) {
+			case 's': speedUp = std::stod( optarg ); break;
+			case 'p': profile = loadProfile( optarg ); break;
+			case 'c': extraConfig = optarg; break;
+			case 't': tracePath = optarg; break;
+			case 'n': model.sensorNoise = std::stod( optarg ); break;
+			case 'd':
+				LogStream::get().setTreshold( LogBuffer::Severity::DEBUG );
+				RuntimeConfig::overrideLogTreshold( LogBuffer::Severity::DEBUG );
+				break;
+			default:
+				std::cerr << "Usage: " << argv[0] << " [-s <speed-up>] [-p <profile>] [-c <config>] [-t <trace.csv>] [-n <noise>] [-d]" << std::endl;
+				return EXIT_FAILURE;
+		}
+	}
+	if( speedUp < 1.0 ) {
+		std::cerr << "The speed-up must be at least 1" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::string const dir( "/dev/shm/amdgpu-hwmon-sim-" + std::to_string( getpid() ) );
+	mkdir( dir.c_str(), 0700 );
+	std::ofstream( dir + "/temp1_input" ) << std::lround( ( model.ambient + profile.front().load / model.passiveConductance ) * 1000.0 ) << '\n';
+	std::ofstream( dir + "/fan1_input" ) << 0 << '\n';
+	std::ofstream( dir + "/pwm1" ) << 0 << '\n';
+	std::ofstream( dir + "/pwm1_enable" ) << PWMActuator::PwmMode::AUTO_CONTROL << '\n';
+	writeConfig( dir + "/amdgpu-fanctrl.conf", dir, extraConfig, speedUp );
+
+	RuntimeConfig::publish( RuntimeConfig::load( dir + "/amdgpu-fanctrl.conf" ) );
+
+	PWMControllers& controllers( PWMControllers::get() );
+	std::vector<SegmentResult> results;
+
+	// The model thread blocks all signals such that they are received by the
+	// control loop
+	sigset_t all, previous;
+	sigfillset( &all );
+	pthread_sigmask( SIG_SETMASK, &all, &previous );
+	std::thread modelThread( simulate, std::cref( model ), std::cref( profile ), speedUp, std::cref( dir ), std::cref( tracePath ), std::ref( results ) );
+	pthread_sigmask( SIG_SETMASK, &previous, nullptr );
+
+	timespec cpuStart, cpuStop;
+	clock_gettime( CLOCK_THREAD_CPUTIME_ID, &cpuStart );
+	int const result = controllers.run();
+	clock_gettime( CLOCK_THREAD_CPUTIME_ID, &cpuStop );
+	modelThread.join();
+
+	double simulatedTime = 0.0;
+	for( Segment const& s : profile ) simulatedTime += s.duration;
+	double const cpuTime = ( cpuStop.tv_sec - cpuStart.tv_sec ) + ( cpuStop.tv_nsec - cpuStart.tv_nsec ) * 1e-9;
+	PWMActuator::Ptr const actuator( PWMActuatorFactory::get().getActuator( dir + "/pwm1" ) );
+
+	report( profile, results );
+	std::cout << "speed-up:              " << speedUp << "x\n"
+	          << "control interval:      " << RuntimeConfig::getCurrent()->getControlInterval().count() << " ms (real)\n"
+	          << "simulated time:        " << simulatedTime << " s\n"
+	          << "actuator writes:       " << actuator->getWritesIssued() << " issued, "
+	          << actuator->getWritesElided() << " elided\n"
+	          << "control CPU time:      " << std::setprecision( 3 ) << cpuTime * 3600.0 / simulatedTime << " s per simulated hour" << std::endl;
+
+	for( char const* file : { "temp1_input", "fan1_input", "pwm1", "pwm1_enable", "amdgpu-fanctrl.conf" } )
+		unlink( ( dir + "/" + file ).c_str() );
+	rmdir( dir.c_str() );
+	return result;
+}
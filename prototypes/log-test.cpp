@@ -0,0 +1,83 @@
+/**
+ * Benchmarks the cost of `PWMController::update` depending on the log
+ * threshold.
+ *
+ * The controller runs against a fake hwmon device on tmpfs (`/dev/shm`)
+ * with a constant temperature, i.e. the benchmark measures the common case
+ * of a cycle in which the temperature stays within the hysteresis band.
+ * At the `INFO` threshold the debug messages of `update` are filtered and
+ * must not be formatted at all; at the `DEBUG` threshold they are formatted
+ * and passed to syslog.
+ *
+ * Usage: amdgpu-log-test [<iterations>]
+ */
+
+#include "controller_batch.h"
+#include "logger2.h"
+#include "pwm_actuator_factory.h"
+#include "pwm_controller.h"
+#include "runtime_config.h"
+#include "temp_sensor_factory.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace AmdGpuFanControl;
+
+typedef std::chrono::steady_clock Clock;
+
+static double benchUpdate( PWMController& controller, LogBuffer::Severity const treshold, unsigned long n ) {
+	LogStream::get().setTreshold( treshold );
+	Clock::time_point const start = Clock::now();
+	for( unsigned long i = 0; i != n; i++ ) controller.update();
+	Clock::time_point const stop = Clock::now();
+	return std::chrono::duration<double, std::nano>( stop - start ).count() / n;
+}
+
+int main( int argc, char* argv[] ) {
+	unsigned long const n = argc > 1 ? std::stoul( argv[1] ) : 100000;
+
+	std::string const dir( "/dev/shm/amdgpu-log-test-" + std::to_string( getpid() ) );
+	std::string const tempPath( dir + "/temp1_input" );
+	std::string const pwmPath( dir + "/pwm1" );
+	mkdir( dir.c_str(), 0700 );
+	std::ofstream( tempPath ) << 50000 << '\n';
+	std::ofstream( pwmPath ) << 0 << '\n';
+	std::ofstream( pwmPath + "_enable" ) << PWMActuator::PwmMode::AUTO_CONTROL << '\n';
+
+	double infoNs, debugNs;
+	{
+		RuntimeConfig::ControllerConfig const controllerConfig;
+		TemperatureSensor::Ptr sensor( TemperatureSensorFactory::get().getSensor( tempPath ) );
+		ControllerBatch batch;
+		PWMController controller(
+			controllerConfig,
+			0,
+			TemperatureInput( sensor ),
+			PWMActuatorFactory::get().getActuator( pwmPath ),
+			batch,
+			RuntimeConfig::CONTROL_INTERVAL_DEFAULT_VALUE
+		);
+		sensor->getValue();
+		// The first update always writes the actuator
+		controller.update();
+
+		infoNs = benchUpdate( controller, LogBuffer::Severity::INFO, n );
+		debugNs = benchUpdate( controller, LogBuffer::Severity::DEBUG, n );
+	}
+
+	std::cout << "iterations:        " << n << '\n'
+	          << "update() at INFO:  " << infoNs << " ns/op\n"
+	          << "update() at DEBUG: " << debugNs << " ns/op" << std::endl;
+
+	unlink( tempPath.c_str() );
+	unlink( pwmPath.c_str() );
+	unlink( ( pwmPath + "_enable" ).c_str() );
+	rmdir( dir.c_str() );
+	return EXIT_SUCCESS;
+}
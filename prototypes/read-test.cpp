@@ -0,0 +1,146 @@
+/**
+ * Benchmarks strategies to read a hwmon temperature file.
+ *
+ * Strategies:
+ *  - `ifstream+seekg`: the former read path of `TemperatureSensor`, i.e.
+ *    `seekg(0)` followed by `operator>>` on a stream which is kept open
+ *    (`lseek` is not counted)
+ *  - `read+lseek`: `lseek` and `read` on a raw file descriptor (`lseek` is
+ *    not counted)
+ *  - `pread`: a single `pread` on a raw file descriptor
+ *  - `reopen`: `open`, `read` and `close` for each read (`open` and `close`
+ *    are not counted)
+ *  - `TemperatureSensor`: the production path, i.e. `pread` plus the
+ *    hand-written parser
+ *  - `TemperatureAcquisition/<backend>`: the production batch path with
+ *    either backend, i.e. a loop of `pread` or the submission of the read to
+ *    an io_uring; if io_uring is unavailable the batch falls back to `pread`
+ *
+ * Usage: amdgpu-read-test [<iterations> [<temp*_input file> ...]]
+ *
+ * If no file is given, a fake hwmon file is created on tmpfs (`/dev/shm`),
+ * i.e. the benchmark measures the overhead of the read path itself and not
+ * the latency of the device driver.
+ * Pass real hwmon nodes (e.g. `/sys/class/hwmon/hwmon0/temp1_input`) to
+ * include the latency of the driver.
+ */
+
+#include "bench.h"
+#include "temp_acquisition.h"
+#include "temp_sensor.h"
+#include "temp_sensor_factory.h"
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace AmdGpuFanControl;
+using Benchmark::Result;
+
+static Temperature parse( char const* buffer, ssize_t const n ) {
+	Temperature t = 0;
+	if( n > 0 ) TemperatureSensor::parseValue( buffer, buffer + n, t );
+	return t;
+}
+
+static Result benchStream( std::string const& path, unsigned long n, Temperature& sum ) {
+	std::ifstream fileStream;
+	fileStream.exceptions( std::ifstream::failbit | std::ifstream::badbit );
+	fileStream.open( path );
+	return Benchmark::run( n, [&]( unsigned long ) {
+		Temperature t;
+		fileStream.seekg(0);
+		fileStream >> t;
+		sum += t;
+	} );
+}
+
+static Result benchReadLSeek( std::string const& path, unsigned long n, Temperature& sum ) {
+	int const fd = open( path.c_str(), O_RDONLY | O_CLOEXEC );
+	char buffer[TemperatureSensor::READ_BUFFER_SIZE];
+	Result const r = Benchmark::run( n, [&]( unsigned long ) {
+		lseek( fd, 0, SEEK_SET );
+		sum += parse( buffer, read( fd, buffer, sizeof( buffer ) ) );
+	} );
+	close( fd );
+	return r;
+}
+
+static Result benchPRead( std::string const& path, unsigned long n, Temperature& sum ) {
+	int const fd = open( path.c_str(), O_RDONLY | O_CLOEXEC );
+	char buffer[TemperatureSensor::READ_BUFFER_SIZE];
+	Result const r = Benchmark::run( n, [&]( unsigned long ) {
+		sum += parse( buffer, pread( fd, buffer, sizeof( buffer ), 0 ) );
+	} );
+	close( fd );
+	return r;
+}
+
+static Result benchReopen( std::string const& path, unsigned long n, Temperature& sum ) {
+	char buffer[TemperatureSensor::READ_BUFFER_SIZE];
+	return Benchmark::run( n, [&]( unsigned long ) {
+		int const fd = open( path.c_str(), O_RDONLY | O_CLOEXEC );
+		sum += parse( buffer, read( fd, buffer, sizeof( buffer ) ) );
+		close( fd );
+	} );
+}
+
+static Result benchSensor( TemperatureSensor::Ptr const& sensor, unsigned long n, Temperature& sum ) {
+	Result const r = Benchmark::run( n, [&]( unsigned long ) {
+		sum += sensor->getValue();
+	} );
+	if( sensor->getStatus() != TemperatureSensor::Status::OK )
+		std::cerr << "TemperatureSensor reported an error" << std::endl;
+	return r;
+}
+
+static Result benchAcquisition( TemperatureSensor::Ptr const& sensor, TemperatureAcquisition::Backend const requestedBackend, unsigned long n, Temperature& sum, std::string& backend ) {
+	TemperatureAcquisition acquisition;
+	acquisition.setSensors( TemperatureAcquisition::SensorCollection{ sensor }, requestedBackend );
+	backend = TemperatureAcquisition::getBackendName( acquisition.getBackend() );
+	Result const r = Benchmark::run( n, [&]( unsigned long ) {
+		acquisition.acquire();
+		sum += sensor->getLastValue();
+	} );
+	// The acquisition may have fallen back during the run
+	backend = TemperatureAcquisition::getBackendName( acquisition.getBackend() );
+	return r;
+}
+
+static void benchFile( std::string const& path, bool const isFake, unsigned long n, Temperature& sum ) {
+	Benchmark::printHeader( path, isFake, n );
+	Benchmark::printResult( "ifstream+seekg", benchStream( path, n, sum ) );
+	Benchmark::printResult( "read+lseek", benchReadLSeek( path, n, sum ) );
+	Benchmark::printResult( "pread", benchPRead( path, n, sum ) );
+	Benchmark::printResult( "reopen", benchReopen( path, n, sum ) );
+
+	TemperatureSensor::Ptr sensor( TemperatureSensorFactory::get().getSensor( path ) );
+	Benchmark::printResult( "TemperatureSensor", benchSensor( sensor, n, sum ) );
+	for( TemperatureAcquisition::Backend const requestedBackend : { TemperatureAcquisition::Backend::PREAD, TemperatureAcquisition::Backend::IO_URING } ) {
+		std::string backend;
+		Result const r = benchAcquisition( sensor, requestedBackend, n, sum, backend );
+		std::string const name( "TemperatureAcquisition/" + backend );
+		Benchmark::printResult( name.c_str(), r );
+	}
+	std::cout << std::endl;
+}
+
+int main( int argc, char* argv[] ) {
+	unsigned long const n = argc > 1 ? std::stoul( argv[1] ) : 1000000;
+	std::vector<std::string> paths( argv + std::min( argc, 2 ), argv + argc );
+	bool const isFake = paths.empty();
+
+	if( isFake ) {
+		paths.push_back( "/dev/shm/amdgpu-read-test-" + std::to_string( getpid() ) );
+		std::ofstream fake( paths.front() );
+		fake << 45000 << '\n';
+	}
+
+	Temperature sum = 0;
+	for( auto const& path : paths ) benchFile( path, isFake, n, sum );
+	std::cout << "checksum:   " << sum << std::endl;
+
+	if( isFake ) unlink( paths.front().c_str() );
+	return EXIT_SUCCESS;
+}
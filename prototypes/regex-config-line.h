@@ -0,0 +1,56 @@
+#ifndef _REGEX_CONFIG_LINE_H_
+#define _REGEX_CONFIG_LINE_H_
+
+/**
+ * The former, regex-based lexer of `RuntimeConfig::ConfigLine`.
+ *
+ * Serves as reference for the fuzz harness (both lexers must agree on
+ * every line) and as baseline for the parse benchmark.
+ */
+
+#include "runtime_config.h"
+
+#include <algorithm>
+#include <regex>
+#include <string>
+
+struct RegexConfigLine {
+	std::string attribute;
+	std::size_t index;
+	std::string value;
+	bool valid;
+	bool failed;
+
+	explicit RegexConfigLine( std::string const& line ) :
+		attribute(),
+		index( AmdGpuFanControl::RuntimeConfig::UNDEFINED_INDEX ),
+		value(),
+		valid( false ),
+		failed( false ) {
+		static std::regex const commentOrEmpty( "^\\s*($|#)" );
+		static std::regex const attrIdxValuePair( "^\\s*([_A-Za-z]+)(?:\\.(\\d+))?\\s*=\\s*((?:\\s*\\S+)+)\\s*$" );
+		std::smatch pieces;
+
+		if( std::regex_search( line, commentOrEmpty ) )
+			return;
+		if( std::regex_match( line, pieces, attrIdxValuePair ) ) {
+			attribute = pieces[1];
+			if( pieces[2].matched ) {
+				// Saturated like `ConfigLine::getIndex`, as `std::stoul` would
+				// throw on overlong indices
+				std::size_t const maxIndex = AmdGpuFanControl::RuntimeConfig::MAX_INDEX;
+				std::string const digits( pieces[2] );
+				index = 0;
+				for( char const c : digits )
+					if( index <= maxIndex ) index = index * 10 + ( c - '0' );
+				index = std::min( index, maxIndex + 1 );
+			}
+			value = pieces[3];
+			valid = true;
+			return;
+		}
+		failed = true;
+	}
+};
+
+#endif
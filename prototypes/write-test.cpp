@@ -0,0 +1,164 @@
+/**
+ * Benchmarks strategies to write a hwmon PWM file.
+ *
+ * Strategies:
+ *  - `ofstream+endl+flush`: the former write path of `PWMActuator`, i.e.
+ *    `operator<<` followed by `std::endl` and `std::flush` on a stream which
+ *    is kept open
+ *  - `ofstream+flush`: as before, but with `'\n'` instead of `std::endl`
+ *  - `write+lseek`: `lseek` and `write` on a raw file descriptor (`lseek` is
+ *    not counted)
+ *  - `pwrite`: a single `pwrite` on a raw file descriptor
+ *  - `reopen`: `open`, `write` and `close` for each write (`open` and
+ *    `close` are not counted)
+ *  - `PWMActuator`: the production path, i.e. formatting into a buffer on
+ *    the stack plus a single `pwrite`
+ *  - `PWMActuator/unchanged`: the production path if the value does not
+ *    change, i.e. the write is elided
+ *
+ * The strategies alternate between two adjacent values such that
+ * `PWMActuator` does not elide any write (apart from the last strategy).
+ *
+ * Usage: amdgpu-write-test [<iterations> [<pwm* file> ...]]
+ *
+ * If no file is given, a fake hwmon file is created on tmpfs (`/dev/shm`),
+ * i.e. the benchmark measures the overhead of the write path itself and not
+ * the latency of the device driver.
+ * Real hwmon nodes (e.g. `/sys/class/hwmon/hwmon0/pwm1`) may be passed
+ * with care: the benchmark takes over manual control of the fan for its
+ * duration (and hands it back to the automatic mode afterwards), but only
+ * writes the current PWM value and its neighbour.
+ */
+
+#include "bench.h"
+#include "pwm_actuator.h"
+#include "pwm_actuator_factory.h"
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace AmdGpuFanControl;
+using Benchmark::Result;
+
+/**
+ * Returns the i-th value to be written, alternating between `base` and its
+ * neighbour.
+ */
+static unsigned int getValue( PwmValue const base, unsigned long const i ) {
+	PwmValue const neighbour = base == 255 ? base - 1 : base + 1;
+	return i % 2 == 0 ? base : neighbour;
+}
+
+static std::size_t format( char* buffer, unsigned int const value ) {
+	char* const end = std::to_chars( buffer, buffer + PWMActuator::WRITE_BUFFER_SIZE - 1, value ).ptr;
+	*end = '\n';
+	return end + 1 - buffer;
+}
+
+static Result benchStreamEndl( std::string const& path, PwmValue const base, unsigned long n ) {
+	std::ofstream fileStream;
+	fileStream.exceptions( std::ofstream::failbit | std::ofstream::badbit );
+	fileStream.open( path );
+	return Benchmark::run( n, [&]( unsigned long i ) {
+		fileStream << getValue( base, i ) << std::endl << std::flush;
+	} );
+}
+
+static Result benchStreamFlush( std::string const& path, PwmValue const base, unsigned long n ) {
+	std::ofstream fileStream;
+	fileStream.exceptions( std::ofstream::failbit | std::ofstream::badbit );
+	fileStream.open( path );
+	return Benchmark::run( n, [&]( unsigned long i ) {
+		fileStream << getValue( base, i ) << '\n' << std::flush;
+	} );
+}
+
+static Result benchWriteLSeek( std::string const& path, PwmValue const base, unsigned long n ) {
+	int const fd = open( path.c_str(), O_WRONLY | O_CLOEXEC );
+	char buffer[PWMActuator::WRITE_BUFFER_SIZE];
+	Result const r = Benchmark::run( n, [&]( unsigned long i ) {
+		lseek( fd, 0, SEEK_SET );
+		if( write( fd, buffer, format( buffer, getValue( base, i ) ) ) == -1 )
+			std::cerr << "write failed" << std::endl;
+	} );
+	close( fd );
+	return r;
+}
+
+static Result benchPWrite( std::string const& path, PwmValue const base, unsigned long n ) {
+	int const fd = open( path.c_str(), O_WRONLY | O_CLOEXEC );
+	char buffer[PWMActuator::WRITE_BUFFER_SIZE];
+	Result const r = Benchmark::run( n, [&]( unsigned long i ) {
+		if( pwrite( fd, buffer, format( buffer, getValue( base, i ) ), 0 ) == -1 )
+			std::cerr << "pwrite failed" << std::endl;
+	} );
+	close( fd );
+	return r;
+}
+
+static Result benchReopen( std::string const& path, PwmValue const base, unsigned long n ) {
+	char buffer[PWMActuator::WRITE_BUFFER_SIZE];
+	return Benchmark::run( n, [&]( unsigned long i ) {
+		int const fd = open( path.c_str(), O_WRONLY | O_CLOEXEC );
+		if( write( fd, buffer, format( buffer, getValue( base, i ) ) ) == -1 )
+			std::cerr << "write failed" << std::endl;
+		close( fd );
+	} );
+}
+
+static Result benchActuator( PWMActuator& actuator, PwmValue const base, unsigned long n, bool const isUnchanged ) {
+	return Benchmark::run( n, [&]( unsigned long i ) {
+		actuator.setValue( isUnchanged ? base : getValue( base, i ) );
+	} );
+}
+
+/**
+ * Reads the current PWM value such that the benchmark does not change the
+ * fan speed noticeably.
+ */
+static PwmValue readCurrentValue( std::string const& path ) {
+	std::ifstream fileStream( path );
+	unsigned int value = 0;
+	fileStream >> value;
+	return std::min( value, 255u );
+}
+
+static void benchFile( std::string const& path, bool const isFake, unsigned long n ) {
+	PwmValue const base = readCurrentValue( path );
+	// The actuator switches to manual control for the whole benchmark, such
+	// that the raw strategies do not write into a file the driver ignores
+	PWMActuator::Ptr actuator( PWMActuatorFactory::get().getActuator( path ) );
+
+	Benchmark::printHeader( path, isFake, n );
+	Benchmark::printResult( "ofstream+endl+flush", benchStreamEndl( path, base, n ) );
+	Benchmark::printResult( "ofstream+flush", benchStreamFlush( path, base, n ) );
+	Benchmark::printResult( "write+lseek", benchWriteLSeek( path, base, n ) );
+	Benchmark::printResult( "pwrite", benchPWrite( path, base, n ) );
+	Benchmark::printResult( "reopen", benchReopen( path, base, n ) );
+	Benchmark::printResult( "PWMActuator", benchActuator( *actuator, base, n, false ) );
+	Benchmark::printResult( "PWMActuator/unchanged", benchActuator( *actuator, base, n, true ) );
+	std::cout << std::endl;
+}
+
+int main( int argc, char* argv[] ) {
+	unsigned long const n = argc > 1 ? std::stoul( argv[1] ) : 1000000;
+	std::vector<std::string> paths( argv + std::min( argc, 2 ), argv + argc );
+	bool const isFake = paths.empty();
+
+	if( isFake ) {
+		paths.push_back( "/dev/shm/amdgpu-write-test-" + std::to_string( getpid() ) );
+		std::ofstream( paths.front() ) << 128 << '\n';
+		std::ofstream( paths.front() + "_enable" ) << PWMActuator::PwmMode::AUTO_CONTROL << '\n';
+	}
+
+	for( auto const& path : paths ) benchFile( path, isFake, n );
+
+	if( isFake ) {
+		unlink( paths.front().c_str() );
+		unlink( ( paths.front() + "_enable" ).c_str() );
+	}
+	return EXIT_SUCCESS;
+}
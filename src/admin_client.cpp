@@ -0,0 +1,96 @@
+/**
+ * Sends a single request to the administration interface of
+ * `amdgpu-fanctrl`.
+ *
+ * Usage: amdgpu-fanctrl-admin [-s <admin socket>] <request>...
+ *
+ * The arguments form the request, e.g.
+ * `amdgpu-fanctrl-admin OVERRIDE 0 180 60` pins the PWM value of the
+ * first controller to 180 for a minute, see `PWMControllers` for all
+ * requests.
+ * The data lines of the response are printed to standard output; if the
+ * daemon rejects the request, its message is printed to standard error
+ * and the tool fails.
+ */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static char const* const DEFAULT_SOCKET_PATH = "/run/amdgpu-fanctrl.admin";
+
+int main( int argc, char* argv[] ) {
+	char const* socketPath = DEFAULT_SOCKET_PATH;
+	int argIdx = 1;
+	if( argc > 2 && std::strcmp( argv[1], "-s" ) == 0 ) {
+		socketPath = argv[2];
+		argIdx = 3;
+	}
+	if( argIdx >= argc ) {
+		std::fprintf( stderr, "Usage: %s [-s <admin socket>] <request>...\n", argv[0] );
+		return EXIT_FAILURE;
+	}
+	std::string request;
+	for( int i = argIdx; i < argc; i++ ) {
+		if( i != argIdx ) request += ' ';
+		request += argv[i];
+	}
+	request += '\n';
+
+	sockaddr_un address;
+	std::memset( &address, 0, sizeof( address ) );
+	address.sun_family = AF_UNIX;
+	if( std::strlen( socketPath ) >= sizeof( address.sun_path ) ) {
+		std::fprintf( stderr, "%s: path too long\n", socketPath );
+		return EXIT_FAILURE;
+	}
+	std::strcpy( address.sun_path, socketPath );
+	int const fd = socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+	if( fd == -1 || connect( fd, reinterpret_cast<sockaddr*>( &address ), sizeof( address ) ) == -1 ) {
+		std::fprintf( stderr, "%s: %s\n", socketPath, std::strerror( errno ) );
+		return EXIT_FAILURE;
+	}
+	timeval const timeout = { 5, 0 };
+	setsockopt( fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof( timeout ) );
+
+	// The daemon closes the connection once it has answered all requests
+	// and the client has closed its end
+	if( send( fd, request.data(), request.size(), MSG_NOSIGNAL ) != static_cast<ssize_t>( request.size() ) ) {
+		std::fprintf( stderr, "%s: %s\n", socketPath, std::strerror( errno ) );
+		return EXIT_FAILURE;
+	}
+	shutdown( fd, SHUT_WR );
+
+	std::string response;
+	for(;;) {
+		char buffer[4096];
+		ssize_t const n = read( fd, buffer, sizeof( buffer ) );
+		if( n == 0 ) break;
+		if( n < 0 ) {
+			std::fprintf( stderr, "%s: %s\n", socketPath, std::strerror( errno ) );
+			return EXIT_FAILURE;
+		}
+		response.append( buffer, n );
+	}
+	close( fd );
+
+	// All lines but the last one are data, the last one is the status
+	std::string::size_type const end = response.rfind( '\n', response.empty() ? 0 : response.size() - 2 );
+	std::string::size_type const statusPos = end == std::string::npos ? 0 : end + 1;
+	std::string status( response.substr( statusPos ) );
+	if( !status.empty() && status.back() == '\n' ) status.pop_back();
+	std::fwrite( response.data(), 1, statusPos, stdout );
+	if( status == "OK" ) return EXIT_SUCCESS;
+	if( status.compare( 0, 6, "ERROR " ) == 0 ) {
+		std::fprintf( stderr, "%s\n", status.c_str() + 6 );
+	} else {
+		std::fprintf( stderr, "%s: incomplete response\n", socketPath );
+	}
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,209 @@
+#include "admin_server.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace AmdGpuFanControl {
+
+std::size_t const AdminServer::MAX_CLIENTS( 8 );
+std::size_t const AdminServer::MAX_REQUEST_SIZE( 1024 );
+
+AdminServer::AdminServer() :
+	socketPath(),
+	listenFd( -1 ),
+	epollFd( -1 ),
+	clients() {
+}
+
+AdminServer::~AdminServer() {
+	close();
+}
+
+/**
+ * Creates the socket; a previous socket is closed.
+ *
+ * A stale socket file of a previous instance is removed.
+ * The socket file is only accessible by the owner (usually root), as the
+ * interface controls the fans.
+ */
+void AdminServer::open( std::string const& path ) {
+	close();
+	sockaddr_un address;
+	std::memset( &address, 0, sizeof( address ) );
+	address.sun_family = AF_UNIX;
+	if( path.size() >= sizeof( address.sun_path ) )
+		throw std::invalid_argument( "Admin socket path too long" );
+	std::memcpy( address.sun_path, path.c_str(), path.size() );
+
+	epollFd = epoll_create1( EPOLL_CLOEXEC );
+	if( epollFd == -1 )
+		throw std::system_error( errno, std::generic_category(), "epoll_create1" );
+	listenFd = socket( AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 );
+	if( listenFd == -1 ) {
+		int const e = errno;
+		close();
+		throw std::system_error( e, std::generic_category(), "socket" );
+	}
+	unlink( path.c_str() );
+	if(
+		bind( listenFd, reinterpret_cast<sockaddr*>( &address ), sizeof( address ) ) == -1 ||
+		chmod( path.c_str(), 0600 ) == -1 ||
+		listen( listenFd, 4 ) == -1
+	) {
+		int const e = errno;
+		close();
+		unlink( path.c_str() );
+		throw std::system_error( e, std::generic_category(), path );
+	}
+	socketPath = path;
+
+	epoll_event event;
+	event.events = EPOLLIN;
+	event.data.fd = listenFd;
+	if( epoll_ctl( epollFd, EPOLL_CTL_ADD, listenFd, &event ) == -1 ) {
+		int const e = errno;
+		close();
+		throw std::system_error( e, std::generic_category(), "epoll_ctl" );
+	}
+}
+
+void AdminServer::close() {
+	while( !clients.empty() ) drop( clients.size() - 1 );
+	if( listenFd != -1 ) {
+		::close( listenFd );
+		if( !socketPath.empty() ) unlink( socketPath.c_str() );
+	}
+	if( epollFd != -1 ) ::close( epollFd );
+	listenFd = epollFd = -1;
+	socketPath.clear();
+}
+
+/**
+ * Accepts pending connections and appends all complete request lines to
+ * the given sequence; never blocks.
+ *
+ * The caller must answer each request by `respond`, in order.
+ */
+void AdminServer::serve( RequestSeq& requests ) {
+	epoll_event events[MAX_CLIENTS + 1];
+	int const n = epoll_wait( epollFd, events, MAX_CLIENTS + 1, 0 );
+	for( int i = 0; i < n; i++ ) {
+		int const fd = events[i].data.fd;
+		if( fd == listenFd ) {
+			accept();
+			continue;
+		}
+		for( ClientSeq::size_type c = 0; c != clients.size(); c++ ) {
+			if( clients[c].fd != fd ) continue;
+			receive( c, requests );
+			break;
+		}
+	}
+}
+
+void AdminServer::accept() {
+	for(;;) {
+		int const fd = accept4( listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC );
+		if( fd == -1 ) return;
+		epoll_event event;
+		event.events = EPOLLIN | EPOLLRDHUP;
+		event.data.fd = fd;
+		if( clients.size() == MAX_CLIENTS || epoll_ctl( epollFd, EPOLL_CTL_ADD, fd, &event ) == -1 ) {
+			::close( fd );
+			continue;
+		}
+		clients.push_back( { fd, std::string(), 0, false } );
+	}
+}
+
+/**
+ * Reads everything the client has sent so far and splits it into lines.
+ */
+void AdminServer::receive( ClientSeq::size_type const idx, RequestSeq& requests ) {
+	Client& client( clients[idx] );
+	bool isFailed = false;
+	for(;;) {
+		char buffer[512];
+		ssize_t const n = recv( client.fd, buffer, sizeof( buffer ), 0 );
+		if( n > 0 ) {
+			client.input.append( buffer, n );
+			continue;
+		}
+		if( n == 0 ) {
+			client.isEof = true;
+			// The connection remains readable; stop watching it
+			epoll_ctl( epollFd, EPOLL_CTL_DEL, client.fd, nullptr );
+		} else if( errno == EINTR ) {
+			continue;
+		} else if( errno != EAGAIN && errno != EWOULDBLOCK ) {
+			isFailed = true;
+		}
+		break;
+	}
+
+	// The limit applies to each request, i.e. to each complete line and to
+	// the unterminated tail, not to everything a client has pipelined
+	bool isTooLong = false;
+	std::string::size_type begin = 0;
+	for( std::string::size_type end; !isFailed && ( end = client.input.find( '\n', begin ) ) != std::string::npos; begin = end + 1 ) {
+		std::string::size_type length = end - begin;
+		if( length > MAX_REQUEST_SIZE ) {
+			isTooLong = true;
+			break;
+		}
+		if( length != 0 && client.input[end - 1] == '\r' ) length--;
+		requests.push_back( { client.fd, client.input.substr( begin, length ) } );
+		client.pendingRequests++;
+	}
+	client.input.erase( 0, begin );
+
+	if( isFailed || isTooLong || client.input.size() > MAX_REQUEST_SIZE ) {
+		static char const TOO_LONG[] = "ERROR request too long\n";
+		if( !isFailed )
+			send( client.fd, TOO_LONG, sizeof( TOO_LONG ) - 1, MSG_DONTWAIT | MSG_NOSIGNAL );
+		// Requests of this client which have not been answered yet are
+		// dropped as well
+		for( Request& request : requests ) {
+			if( request.clientFd == client.fd ) request.clientFd = -1;
+		}
+		drop( idx );
+		return;
+	}
+	if( client.isEof && client.pendingRequests == 0 ) drop( idx );
+}
+
+/**
+ * Sends the response to a request; the response must end with a newline.
+ *
+ * The client is disconnected if the response does not fit into its socket
+ * buffer at once.
+ */
+void AdminServer::respond( Request const& request, std::string const& response ) {
+	for( ClientSeq::size_type c = 0; c != clients.size(); c++ ) {
+		Client& client( clients[c] );
+		if( client.fd != request.clientFd ) continue;
+		client.pendingRequests--;
+		ssize_t const n = send( client.fd, response.data(), response.size(), MSG_DONTWAIT | MSG_NOSIGNAL );
+		if(
+			n < 0 || static_cast<std::size_t>( n ) != response.size() ||
+			( client.isEof && client.pendingRequests == 0 )
+		)
+			drop( c );
+		return;
+	}
+}
+
+void AdminServer::drop( ClientSeq::size_type const idx ) {
+	if( !clients[idx].isEof ) epoll_ctl( epollFd, EPOLL_CTL_DEL, clients[idx].fd, nullptr );
+	::close( clients[idx].fd );
+	clients.erase( clients.begin() + idx );
+}
+
+}
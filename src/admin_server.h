@@ -0,0 +1,81 @@
+#ifndef _ADMIN_SERVER_H_
+#define _ADMIN_SERVER_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace AmdGpuFanControl {
+
+/**
+ * Serves the administration interface on a Unix domain socket.
+ *
+ * The protocol is line-based: a client sends one request per line and
+ * receives zero or more data lines followed by a single status line, which
+ * is either `OK` or `ERROR <message>`.
+ * The requests themselves are interpreted by the owner, see
+ * `PWMControllers`; this class only moves lines in and out.
+ *
+ * The server runs on the control thread and never blocks it: the listening
+ * socket and all connections are non-blocking and live in an `epoll`
+ * instance of their own, whose file descriptor the owner adds to its wait
+ * set.
+ * If the descriptor becomes readable, `serve` accepts new connections and
+ * collects the complete request lines without waiting for more data.
+ * A client which sends an overlong request or does not read its responses
+ * (i.e. whose socket buffer is full) is disconnected rather than waited
+ * for.
+ * A client may close its end after sending its requests (e.g.
+ * `echo STATUS | socat - UNIX-CONNECT:<path>`); the connection is closed
+ * once all its requests have been answered.
+ */
+class AdminServer {
+	public:
+		struct Request {
+			int clientFd;
+			std::string line;
+		};
+		typedef std::vector<Request> RequestSeq;
+
+		static std::size_t const MAX_CLIENTS;
+		static std::size_t const MAX_REQUEST_SIZE;
+
+	public:
+		AdminServer();
+		AdminServer( AdminServer const& ) = delete;
+		AdminServer& operator=( AdminServer const& ) = delete;
+		~AdminServer();
+
+	public:
+		void open( std::string const& path );
+		void close();
+		bool isOpen() const { return listenFd != -1; };
+		int getFd() const { return epollFd; };
+		std::string const& getSocketPath() const { return socketPath; };
+		void serve( RequestSeq& requests );
+		void respond( Request const& request, std::string const& response );
+
+	private:
+		struct Client {
+			int fd;
+			std::string input;
+			std::size_t pendingRequests;
+			bool isEof;
+		};
+		typedef std::vector<Client> ClientSeq;
+
+	private:
+		void accept();
+		void receive( ClientSeq::size_type const idx, RequestSeq& requests );
+		void drop( ClientSeq::size_type const idx );
+
+	private:
+		std::string socketPath;
+		int listenFd;
+		int epollFd;
+		ClientSeq clients;
+};
+
+}
+
+#endif
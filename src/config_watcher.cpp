@@ -0,0 +1,73 @@
+#include "config_watcher.h"
+
+#include <cerrno>
+#include <climits>
+#include <system_error>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace AmdGpuFanControl {
+
+ConfigWatcher::ConfigWatcher() :
+	fd( -1 ),
+	filePath(),
+	fileName() {
+}
+
+ConfigWatcher::~ConfigWatcher() {
+	close();
+}
+
+/**
+ * Starts watching the given file; any previous watch is ended.
+ *
+ * @throw std::system_error if the directory of the file cannot be watched
+ */
+void ConfigWatcher::watch( std::string const& path ) {
+	close();
+	std::string::size_type const slash = path.rfind( '/' );
+	std::string const dir( slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr( 0, slash ) );
+
+	fd = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+	if( fd == -1 )
+		throw std::system_error( errno, std::generic_category(), "inotify_init1" );
+	if( inotify_add_watch( fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO ) == -1 ) {
+		int const e = errno;
+		close();
+		throw std::system_error( e, std::generic_category(), dir );
+	}
+	filePath = path;
+	fileName = slash == std::string::npos ? path : path.substr( slash + 1 );
+}
+
+void ConfigWatcher::close() {
+	if( fd != -1 ) ::close( fd );
+	fd = -1;
+	filePath.clear();
+	fileName.clear();
+}
+
+/**
+ * Reads all pending events.
+ *
+ * Several changes in short succession are collapsed into a single one.
+ *
+ * @return `true` if any event concerns the watched file
+ */
+bool ConfigWatcher::consume() {
+	// Large enough for at least one event with the longest possible name
+	alignas( inotify_event ) char buffer[sizeof( inotify_event ) + NAME_MAX + 1];
+	bool isChanged = false;
+	for(;;) {
+		ssize_t const n = read( fd, buffer, sizeof( buffer ) );
+		if( n <= 0 ) break;
+		for( char const* p = buffer; p < buffer + n; ) {
+			inotify_event const* const event = reinterpret_cast<inotify_event const*>( p );
+			if( event->len != 0 && fileName.compare( event->name ) == 0 ) isChanged = true;
+			p += sizeof( inotify_event ) + event->len;
+		}
+	}
+	return isChanged;
+}
+
+}
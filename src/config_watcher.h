@@ -0,0 +1,43 @@
+#ifndef _CONFIG_WATCHER_H_
+#define _CONFIG_WATCHER_H_
+
+#include <string>
+
+namespace AmdGpuFanControl {
+
+/**
+ * Watches the configuration file for changes via inotify.
+ *
+ * The directory of the file is watched rather than the file itself, as
+ * editors and configuration management tools usually replace a file by
+ * renaming a temporary file, which would silently end a watch on the file.
+ * A change is reported once the file has been written and closed or
+ * another file has been renamed to it, i.e. never for a half-written file.
+ *
+ * The watcher does not wait itself; the owner adds the file descriptor to
+ * its wait set and calls `consume` if the descriptor becomes readable.
+ */
+class ConfigWatcher {
+	public:
+		ConfigWatcher();
+		ConfigWatcher( ConfigWatcher const& ) = delete;
+		ConfigWatcher& operator=( ConfigWatcher const& ) = delete;
+		~ConfigWatcher();
+
+	public:
+		void watch( std::string const& path );
+		void close();
+		bool isOpen() const { return fd != -1; };
+		int getFd() const { return fd; };
+		std::string const& getFilePath() const { return filePath; };
+		bool consume();
+
+	private:
+		int fd;
+		std::string filePath;
+		std::string fileName;
+};
+
+}
+
+#endif
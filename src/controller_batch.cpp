@@ -0,0 +1,140 @@
+#include "controller_batch.h"
+
+#include <limits>
+
+namespace AmdGpuFanControl {
+
+Temperature const ControllerBatch::INITIAL_TEMPERATURE( std::numeric_limits<Temperature>::min() );
+PwmValue const ControllerBatch::INITIAL_PWM_VALUE( std::numeric_limits<PwmValue>::max() );
+
+/**
+ * C'tor.
+ *
+ * The table starts with a single entry for the padding lanes which always
+ * yields 0.
+ */
+ControllerBatch::ControllerBatch() :
+	laneCount( 0 ),
+	temperatures(),
+	lastTemperatures(),
+	lastPwmValues(),
+	forcedUpdates(),
+	upwardHysteresis(),
+	downwardHysteresis(),
+	curveStarts(),
+	curveMaxIndices(),
+	curveOffsets(),
+	updateNeeded(),
+	tableIndices(),
+	calculatedPwmValues(),
+	table( 1, 0 ) {
+}
+
+/**
+ * Adds a lane for a controller.
+ *
+ * The first evaluation of a new lane always needs an update.
+ */
+ControllerBatch::Lane ControllerBatch::addLane( RuntimeConfig::ControllerConfig const& config ) {
+	Lane const lane = laneCount++;
+	if( laneCount > temperatures.size() )
+		resize( temperatures.size() + BLOCK_SIZE );
+
+	FanCurve const& curve( config.getCurve() );
+	temperatures[lane] = INITIAL_TEMPERATURE;
+	lastTemperatures[lane] = INITIAL_TEMPERATURE;
+	lastPwmValues[lane] = INITIAL_PWM_VALUE;
+	forcedUpdates[lane] = 1;
+	upwardHysteresis[lane] = config.getUpwardTemperatureHysteresis();
+	downwardHysteresis[lane] = config.getDownwardTemperatureHysteresis();
+	curveStarts[lane] = curve.getStart();
+	curveMaxIndices[lane] = curve.getMaxIndex();
+	curveOffsets[lane] = table.size();
+	table.insert( table.end(), curve.getTable().begin(), curve.getTable().end() );
+	return lane;
+}
+
+/**
+ * Resizes all arrays; padding lanes never need an update.
+ */
+void ControllerBatch::resize( std::size_t const paddedSize ) {
+	temperatures.resize( paddedSize, 0 );
+	lastTemperatures.resize( paddedSize, 0 );
+	lastPwmValues.resize( paddedSize, 0 );
+	forcedUpdates.resize( paddedSize, 0 );
+	upwardHysteresis.resize( paddedSize, 0 );
+	downwardHysteresis.resize( paddedSize, 0 );
+	curveStarts.resize( paddedSize, 0 );
+	curveMaxIndices.resize( paddedSize, 0 );
+	curveOffsets.resize( paddedSize, 0 );
+	updateNeeded.resize( paddedSize, 0 );
+	tableIndices.resize( paddedSize, 0 );
+	calculatedPwmValues.resize( paddedSize, 0 );
+}
+
+/**
+ * Evaluates the hysteresis and computes the index into the table for one
+ * block of lanes.
+ *
+ * The loop has a fixed trip count and the outputs are declared as not
+ * aliasing any input, such that the compiler vectorizes the loop even with
+ * the cheap cost model of `-O2` which neither permits an epilogue nor a
+ * runtime alias check.
+ */
+static void evaluateBlock(
+	std::uint32_t const* __restrict__ const t,
+	std::uint32_t const* __restrict__ const lastT,
+	std::uint32_t const* __restrict__ const forced,
+	std::uint32_t const* __restrict__ const upH,
+	std::uint32_t const* __restrict__ const downH,
+	std::uint32_t const* __restrict__ const start,
+	std::uint32_t const* __restrict__ const maxIdx,
+	std::uint32_t const* __restrict__ const offset,
+	std::uint32_t* __restrict__ const needed,
+	std::uint32_t* __restrict__ const idx
+) {
+	for( std::size_t i = 0; i != ControllerBatch::BLOCK_SIZE; i++ ) {
+		std::uint32_t const isUp = t[i] > lastT[i] + upH[i];
+		std::uint32_t const isDown = t[i] + downH[i] < lastT[i];
+		needed[i] = isUp | isDown | forced[i];
+
+		// Equivalent to `FanCurve::getPwmValue`: index 0 below the start of
+		// the curve, otherwise one entry per `RESOLUTION` clamped to the end
+		std::uint32_t const isAbove = t[i] >= start[i];
+		std::uint32_t const distance = ( t[i] - start[i] ) * isAbove;
+		std::uint32_t const curveIdx = ( distance / FanCurve::RESOLUTION + 1 ) * isAbove;
+		idx[i] = offset[i] + ( curveIdx < maxIdx[i] ? curveIdx : maxIdx[i] );
+	}
+}
+
+/**
+ * Evaluates all lanes.
+ *
+ * Sets `isUpdateNeeded` and `getCalculatedPwmValue` for each lane based
+ * on the temperature which has been set by `setTemperature`.
+ * The calculated PWM value is computed for every lane, regardless of
+ * whether the lane needs an update, to keep the loop free of branches.
+ *
+ * @internal The evaluation is split into two loops: the first one only
+ * performs arithmetic and is vectorized, the second one gathers the values
+ * from the table, which cannot be vectorized without a gather instruction.
+ */
+void ControllerBatch::evaluate() {
+	std::size_t const paddedSize = temperatures.size();
+	for( std::size_t b = 0; b < paddedSize; b += BLOCK_SIZE ) {
+		evaluateBlock(
+			&temperatures[b], &lastTemperatures[b], &forcedUpdates[b],
+			&upwardHysteresis[b], &downwardHysteresis[b],
+			&curveStarts[b], &curveMaxIndices[b], &curveOffsets[b],
+			&updateNeeded[b], &tableIndices[b]
+		);
+	}
+
+	PwmValue const* const values = table.data();
+	std::uint32_t const* const idx = tableIndices.data();
+	PwmValue* const calculated = calculatedPwmValues.data();
+	for( std::size_t i = 0; i != paddedSize; i++ )
+		calculated[i] = values[idx[i]];
+}
+
+}
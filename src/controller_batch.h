@@ -0,0 +1,94 @@
+#ifndef _CONTROLLER_BATCH_H_
+#define _CONTROLLER_BATCH_H_
+
+#include "runtime_config.h"
+#include "fan_curve.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace AmdGpuFanControl {
+
+/**
+ * Holds the numeric state of all controllers as a struct of arrays.
+ *
+ * Each controller occupies one lane of the batch.
+ * The per-cycle math (the hysteresis check of `needsUpdate` and the lookup
+ * into the fan curve) is evaluated for all lanes at once by `evaluate`,
+ * whose loops only operate on 32-bit integers in separate arrays and
+ * hence are vectorized by the compiler.
+ * The arrays are padded to a multiple of `BLOCK_SIZE` lanes, such that the
+ * inner loops have a fixed trip count and are vectorized entirely without
+ * a scalar epilogue even by the cheap cost model of `-O2`.
+ *
+ * The fan curves of all lanes are concatenated into a single table.
+ *
+ * Everything which is not part of the math (logging, actuator writes,
+ * statistics) stays with `PWMController` which only acts on lanes whose
+ * `isUpdateNeeded` flag is set.
+ */
+class ControllerBatch {
+	public:
+		typedef std::size_t Lane;
+		typedef std::vector<std::uint32_t> LaneSeq;
+
+		static constexpr std::size_t BLOCK_SIZE = 8;
+		static Temperature const INITIAL_TEMPERATURE;
+		static PwmValue const INITIAL_PWM_VALUE;
+
+	public:
+		ControllerBatch();
+		ControllerBatch( ControllerBatch const& ) = delete;
+		ControllerBatch& operator=( ControllerBatch const& ) = delete;
+
+	public:
+		Lane addLane( RuntimeConfig::ControllerConfig const& config );
+		std::size_t size() const { return laneCount; };
+		void evaluate();
+
+		void setTemperature( Lane const lane, Temperature const t ) { temperatures[lane] = t; };
+		Temperature getTemperature( Lane const lane ) const { return temperatures[lane]; };
+		Temperature getLastTemperature( Lane const lane ) const { return lastTemperatures[lane]; };
+		PwmValue getLastPwmValue( Lane const lane ) const { return lastPwmValues[lane]; };
+		bool isUpdateNeeded( Lane const lane ) const { return updateNeeded[lane] != 0; };
+		PwmValue getCalculatedPwmValue( Lane const lane ) const { return calculatedPwmValues[lane]; };
+
+		/**
+		 * Stores the outcome of an update of a lane.
+		 *
+		 * @param isForced whether the next cycle shall update the lane
+		 * regardless of the hysteresis, e.g. after the fan has been spun up
+		 */
+		void commit( Lane const lane, Temperature const t, PwmValue const pwmValue, bool const isForced ) {
+			lastTemperatures[lane] = t;
+			lastPwmValues[lane] = pwmValue;
+			forcedUpdates[lane] = isForced;
+		};
+
+	private:
+		void resize( std::size_t const paddedSize );
+
+	private:
+		std::size_t laneCount;
+		// Input
+		LaneSeq temperatures;
+		// State
+		LaneSeq lastTemperatures;
+		LaneSeq lastPwmValues;
+		LaneSeq forcedUpdates;
+		// Parameters
+		LaneSeq upwardHysteresis;
+		LaneSeq downwardHysteresis;
+		LaneSeq curveStarts;
+		LaneSeq curveMaxIndices;
+		LaneSeq curveOffsets;
+		// Output
+		LaneSeq updateNeeded;
+		LaneSeq tableIndices;
+		LaneSeq calculatedPwmValues;
+		FanCurve::LookupTable table;
+};
+
+}
+
+#endif
@@ -0,0 +1,82 @@
+#include "fan_curve.h"
+
+#include <cstdint>
+#include <stdexcept>
+
+namespace AmdGpuFanControl {
+
+std::size_t const FanCurve::MAX_TABLE_SIZE( 4096 );
+
+/**
+ * Creates an empty curve which keeps the fan off at any temperature.
+ */
+FanCurve::FanCurve() :
+	points(),
+	table( 1, 0 ),
+	offset( 0 ),
+	maxIdx( 0 ),
+	maxPwmValue( 0 ) {
+}
+
+/**
+ * Compiles the curve.
+ *
+ * The points need not be sorted.
+ * Two points with the same temperature define a step.
+ *
+ * @throw std::invalid_argument if the points span a range which exceeds
+ * the maximum size of the table
+ */
+FanCurve::FanCurve( ControlPointSeq const& p ) :
+	points( p ),
+	table(),
+	offset( 0 ),
+	maxIdx( 0 ),
+	maxPwmValue( 0 ) {
+	if( points.empty() ) {
+		table.assign( 1, 0 );
+		return;
+	}
+	std::stable_sort( points.begin(), points.end(),
+		[]( ControlPoint const& a, ControlPoint const& b ) { return a.temp < b.temp; }
+	);
+
+	Temperature const first = points.front().temp;
+	Temperature const span = points.back().temp - first;
+	// Entry 0 represents temperatures below the first point, entry 1 starts
+	// at the first point and the last entry starts at or beyond the last
+	// point; the size is computed in 64 bit as `span + RESOLUTION` may not
+	// fit into a temperature
+	std::uint64_t const size = ( std::uint64_t( span ) + RESOLUTION - 1 ) / RESOLUTION + 2;
+	if( size > MAX_TABLE_SIZE )
+		throw std::invalid_argument( "Fan curve spans too large a temperature range" );
+
+	for( ControlPoint const& cp : points )
+		maxPwmValue = std::max( maxPwmValue, cp.pwmValue );
+	offset = static_cast<long>( first ) - static_cast<long>( RESOLUTION );
+	maxIdx = size - 1;
+	table.resize( size );
+	table[0] = 0;
+	for( std::size_t i = 1; i != size; i++ )
+		table[i] = interpolate( first + ( i - 1 ) * RESOLUTION );
+}
+
+PwmValue FanCurve::interpolate( Temperature const temperature ) const {
+	if( temperature < points.front().temp ) return 0;
+	if( temperature >= points.back().temp ) return points.back().pwmValue;
+
+	// Find the segment [lower, upper) which contains the temperature;
+	// segments of zero width (steps) are skipped implicitly
+	auto const upper = std::upper_bound( points.begin(), points.end(), temperature,
+		[]( Temperature const t, ControlPoint const& cp ) { return t < cp.temp; }
+	);
+	auto const lower = upper - 1;
+	long long const dt = temperature - lower->temp;
+	long long const width = upper->temp - lower->temp;
+	long long const rise = static_cast<long long>( upper->pwmValue ) - lower->pwmValue;
+	// `lower->pwmValue * width + rise * dt` is non-negative as the result
+	// lies between both PWM values, hence the division rounds down
+	return ( static_cast<long long>( lower->pwmValue ) * width + rise * dt ) / width;
+}
+
+}
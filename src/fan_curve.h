@@ -0,0 +1,80 @@
+#ifndef _FAN_CURVE_H_
+#define _FAN_CURVE_H_
+
+#include "types.h"
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace AmdGpuFanControl {
+
+/**
+ * Maps a temperature onto a PWM value along a piecewise linear curve.
+ *
+ * The curve is defined by an arbitrary number of control points.
+ * Below the first point the fan is off (PWM value 0), between two points
+ * the PWM value is linearly interpolated and beyond the last point the
+ * PWM value of the last point applies.
+ *
+ * Upon construction the curve is compiled into a dense lookup table with
+ * a resolution of `RESOLUTION` m°C which covers the range between the
+ * first and the last point.
+ * The interpolation is computed once per table entry in integer
+ * arithmetic, i.e. the slope of each segment is applied as an exact
+ * fraction and the result is rounded down like the former floating-point
+ * implementation.
+ * Hence, a lookup is a single clamp and a single array index.
+ */
+class FanCurve {
+	public:
+		typedef std::vector<ControlPoint> ControlPointSeq;
+		typedef std::vector<PwmValue> LookupTable;
+
+		static constexpr Temperature RESOLUTION = 100;
+		/**
+		 * Upper bound for the size of the table to guard against typos; covers
+		 * a range of more than 400 °C.
+		 */
+		static std::size_t const MAX_TABLE_SIZE;
+
+	public:
+		FanCurve();
+		FanCurve( ControlPointSeq const& points );
+
+	public:
+		PwmValue getPwmValue( Temperature const temperature ) const {
+			long const idx = ( static_cast<long>( temperature ) - offset ) / static_cast<long>( RESOLUTION );
+			return table[std::clamp( idx, 0L, maxIdx )];
+		};
+		ControlPointSeq const& getControlPoints() const { return points; };
+		LookupTable const& getTable() const { return table; };
+		LookupTable::size_type getTableSize() const { return table.size(); };
+		/**
+		 * Returns the temperature of the first point, i.e. the temperature at
+		 * which index 1 of the table starts.
+		 */
+		Temperature getStart() const { return offset + RESOLUTION; };
+		LookupTable::size_type getMaxIndex() const { return maxIdx; };
+		/**
+		 * Returns the highest PWM value of all points.
+		 */
+		PwmValue getMaxPwmValue() const { return maxPwmValue; };
+
+	private:
+		PwmValue interpolate( Temperature const temperature ) const;
+
+	private:
+		ControlPointSeq points;
+		LookupTable table;
+		/**
+		 * Temperature which corresponds to index zero of the table; the entry
+		 * at index zero represents any temperature below the first point.
+		 */
+		long offset;
+		long maxIdx;
+		PwmValue maxPwmValue;
+};
+
+}
+
+#endif
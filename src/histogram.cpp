@@ -0,0 +1,43 @@
+#include "histogram.h"
+
+#include <algorithm>
+
+namespace AmdGpuFanControl {
+
+void LatencyHistogram::reset() {
+	buckets.fill( 0 );
+	count = 0;
+	max = 0;
+}
+
+/**
+ * Returns the largest value which falls into the given bucket.
+ */
+std::uint64_t LatencyHistogram::getUpperBound( unsigned const bucket ) {
+	if( bucket < SUB_BUCKET_COUNT ) return bucket;
+	unsigned const shift = bucket / SUB_BUCKET_COUNT - 1;
+	std::uint64_t const lowerBound =
+		static_cast<std::uint64_t>( SUB_BUCKET_COUNT + bucket % SUB_BUCKET_COUNT ) << shift;
+	return lowerBound + ( ( static_cast<std::uint64_t>( 1 ) << shift ) - 1 );
+}
+
+/**
+ * Returns the given percentile.
+ *
+ * The result is the upper bound of the bucket into which the percentile
+ * falls, but never more than the exact maximum.
+ *
+ * @param percentile a value between 0 and 100
+ */
+Latency LatencyHistogram::getPercentile( double const percentile ) const {
+	if( count == 0 ) return Latency::zero();
+	std::uint64_t const rank = std::max<std::uint64_t>( 1, static_cast<std::uint64_t>( percentile / 100.0 * count + 0.5 ) );
+	std::uint64_t seen = 0;
+	for( unsigned b = 0; b != BUCKET_COUNT; b++ ) {
+		seen += buckets[b];
+		if( seen >= rank ) return Latency( std::min( getUpperBound( b ), max ) );
+	}
+	return Latency( max );
+}
+
+}
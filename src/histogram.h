@@ -0,0 +1,65 @@
+#ifndef _HISTOGRAM_H_
+#define _HISTOGRAM_H_
+
+#include "types.h"
+#include <array>
+#include <cstdint>
+
+namespace AmdGpuFanControl {
+
+/**
+ * Histogram of latencies with log-linear buckets.
+ *
+ * The buckets are grouped by powers of two and each group is divided into
+ * `SUB_BUCKET_COUNT` linear sub-buckets.
+ * Hence, the relative error of a reported percentile is bounded by
+ * `1 / SUB_BUCKET_COUNT` across the entire range of 64-bit nanoseconds.
+ *
+ * The histogram has a fixed size and recording a value does not allocate;
+ * the bucket is found by a single comparison (linear range for the
+ * smallest values, log-linear range otherwise) and a count of the leading
+ * zeros, i.e. without a loop.
+ * This is suitable for the control loop.
+ * The maximum is tracked exactly.
+ */
+class LatencyHistogram {
+	public:
+		static constexpr unsigned SUB_BUCKET_BITS = 3;
+		static constexpr unsigned SUB_BUCKET_COUNT = 1u << SUB_BUCKET_BITS;
+		static constexpr unsigned BUCKET_COUNT = 64 * SUB_BUCKET_COUNT;
+
+		typedef std::array<std::uint32_t, BUCKET_COUNT> BucketCollection;
+
+	public:
+		LatencyHistogram() : buckets(), count( 0 ), max( 0 ) {};
+
+	public:
+		void record( Latency const latency ) {
+			std::uint64_t const ns = latency.count() < 0 ? 0 : latency.count();
+			buckets[getBucket( ns )]++;
+			count++;
+			if( ns > max ) max = ns;
+		};
+		void reset();
+		std::uint64_t getCount() const { return count; };
+		Latency getMax() const { return Latency( max ); };
+		Latency getPercentile( double const percentile ) const;
+
+	private:
+		static unsigned getBucket( std::uint64_t const ns ) {
+			if( ns < SUB_BUCKET_COUNT ) return ns;
+			unsigned const msb = 63 - __builtin_clzll( ns );
+			unsigned const shift = msb - SUB_BUCKET_BITS;
+			return ( shift + 1 ) * SUB_BUCKET_COUNT + ( ( ns >> shift ) & ( SUB_BUCKET_COUNT - 1 ) );
+		};
+		static std::uint64_t getUpperBound( unsigned const bucket );
+
+	private:
+		BucketCollection buckets;
+		std::uint64_t count;
+		std::uint64_t max;
+};
+
+}
+
+#endif
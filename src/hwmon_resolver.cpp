@@ -0,0 +1,189 @@
+#include "hwmon_resolver.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+#include <system_error>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace AmdGpuFanControl {
+
+char const* const HwmonResolver::URI_PREFIX = "hwmon://";
+char const* const HwmonResolver::SYSFS_HWMON_PATH = "/sys/class/hwmon";
+
+/**
+ * C'tor.
+ *
+ * Neither the cache nor the hwmon directory are read until the first
+ * reference is resolved.
+ *
+ * @param cacheFilePath the file of the cache; an empty path disables the
+ * cache
+ */
+HwmonResolver::HwmonResolver( std::string const& h, std::string const& c ) :
+	hwmonPath( h ),
+	cacheFilePath( c ),
+	bootId( readAttribute( "/proc/sys/kernel/random/boot_id" ) ),
+	isLoaded( false ),
+	isScanned( false ),
+	directories() {
+}
+
+bool HwmonResolver::isReference( std::string const& path ) {
+	return path.compare( 0, std::char_traits<char>::length( URI_PREFIX ), URI_PREFIX ) == 0;
+}
+
+/**
+ * Resolves a path.
+ *
+ * @throw std::runtime_error if the path is a malformed reference or if no
+ * device or several devices carry the identity
+ */
+std::string HwmonResolver::resolve( std::string const& path ) {
+	if( !isReference( path ) ) return path;
+
+	std::string::size_type const identityStart = std::char_traits<char>::length( URI_PREFIX );
+	std::string::size_type const slash = path.rfind( '/' );
+	if( slash == std::string::npos || slash < identityStart || slash + 1 == path.size() )
+		throw std::runtime_error( "Malformed hwmon reference " + path );
+	std::string const identity( path, identityStart, slash - identityStart );
+	std::string const attribute( path, slash + 1 );
+
+	if( !isLoaded ) loadCache();
+	IdentityMap::const_iterator entry = directories.find( identity );
+	if( ( entry == directories.end() || !isValid( identity, entry->second ) ) && !isScanned ) {
+		scan();
+		writeCache();
+		entry = directories.find( identity );
+	}
+	if( entry == directories.end() )
+		throw std::runtime_error( "No hwmon device " + identity );
+	if( entry->second.empty() )
+		throw std::runtime_error( "Ambiguous hwmon device " + identity + "; use the device address instead" );
+	return entry->second + "/" + attribute;
+}
+
+/**
+ * Loads the cache unless it has been written during a different boot.
+ *
+ * The first line holds the boot ID and each further line an identity and
+ * a directory separated by a tab.
+ */
+void HwmonResolver::loadCache() {
+	isLoaded = true;
+	if( cacheFilePath.empty() ) return;
+	std::ifstream cache( cacheFilePath );
+	std::string line;
+	if( !std::getline( cache, line ) || bootId.empty() || line != bootId ) return;
+	while( std::getline( cache, line ) ) {
+		std::string::size_type const tab = line.find( '\t' );
+		if( tab == std::string::npos ) continue;
+		directories[line.substr( 0, tab )] = line.substr( tab + 1 );
+	}
+}
+
+/**
+ * Writes the cache atomically, i.e. a concurrently starting daemon either
+ * sees the previous or the new cache.
+ *
+ * Ambiguous identities are not cached.
+ * Failures are ignored as the cache is merely an optimization.
+ */
+void HwmonResolver::writeCache() const {
+	if( cacheFilePath.empty() || bootId.empty() ) return;
+	std::string::size_type const slash = cacheFilePath.rfind( '/' );
+	if( slash != std::string::npos && slash != 0 )
+		mkdir( cacheFilePath.substr( 0, slash ).c_str(), 0755 );
+
+	std::string const tmpFilePath( cacheFilePath + ".tmp" );
+	{
+		std::ofstream cache( tmpFilePath, std::ios_base::trunc );
+		cache << bootId << '\n';
+		for( auto const& entry : directories ) {
+			if( !entry.second.empty() )
+				cache << entry.first << '\t' << entry.second << '\n';
+		}
+		if( !cache.flush() ) {
+			unlink( tmpFilePath.c_str() );
+			return;
+		}
+	}
+	if( std::rename( tmpFilePath.c_str(), cacheFilePath.c_str() ) != 0 )
+		unlink( tmpFilePath.c_str() );
+}
+
+/**
+ * Scans the hwmon class directory once.
+ *
+ * Each device is registered under its device name and under its `name`
+ * attribute; identities which appear more than once are marked as
+ * ambiguous by an empty directory.
+ */
+void HwmonResolver::scan() {
+	isScanned = true;
+	directories.clear();
+	DIR* const dir = opendir( hwmonPath.c_str() );
+	if( dir == nullptr )
+		throw std::system_error( errno, std::generic_category(), hwmonPath );
+
+	std::set<std::string> seen;
+	auto add = [this, &seen]( std::string const& identity, std::string const& hwmonDir ) {
+		if( identity.empty() ) return;
+		if( seen.insert( identity ).second )
+			directories[identity] = hwmonDir;
+		else
+			directories[identity].clear();
+	};
+	for( dirent const* e; ( e = readdir( dir ) ) != nullptr; ) {
+		if( e->d_name[0] == '.' ) continue;
+		std::string const hwmonDir( hwmonPath + "/" + e->d_name );
+		std::string const deviceName( readDeviceName( hwmonDir ) );
+		std::string const name( readAttribute( hwmonDir + "/name" ) );
+		add( deviceName, hwmonDir );
+		if( name != deviceName ) add( name, hwmonDir );
+	}
+	closedir( dir );
+}
+
+/**
+ * Checks whether a cached directory still carries the identity.
+ */
+bool HwmonResolver::isValid( std::string const& identity, std::string const& dir ) const {
+	return !dir.empty() && (
+		readDeviceName( dir ) == identity || readAttribute( dir + "/name" ) == identity
+	);
+}
+
+/**
+ * Reads the first line of a small attribute file.
+ *
+ * @return the line or an empty string if the file cannot be read
+ */
+std::string HwmonResolver::readAttribute( std::string const& filePath ) {
+	std::ifstream file( filePath );
+	std::string line;
+	std::getline( file, line );
+	return line;
+}
+
+/**
+ * Returns the name of the directory which the `device` link of a hwmon
+ * directory points to, e.g. the PCI address.
+ *
+ * @return the name or an empty string if the directory has no such link
+ */
+std::string HwmonResolver::readDeviceName( std::string const& dir ) {
+	char target[PATH_MAX];
+	ssize_t const n = readlink( ( dir + "/device" ).c_str(), target, sizeof( target ) - 1 );
+	if( n <= 0 ) return std::string();
+	std::string const link( target, n );
+	std::string::size_type const slash = link.rfind( '/' );
+	return slash == std::string::npos ? link : link.substr( slash + 1 );
+}
+
+}
@@ -0,0 +1,75 @@
+#ifndef _HWMON_RESOLVER_H_
+#define _HWMON_RESOLVER_H_
+
+#include <map>
+#include <string>
+
+namespace AmdGpuFanControl {
+
+/**
+ * Resolves hwmon attributes which are referenced by a stable device
+ * identity instead of the hwmon number.
+ *
+ * The kernel numbers the hwmon devices (`/sys/class/hwmon/hwmon<N>`) in
+ * the order in which the drivers register them, which may change between
+ * boots.
+ * Hence, a path in the configuration may be given as
+ *
+ *     hwmon://<identity>/<attribute>
+ *
+ * where the identity is either the name of the device which the `device`
+ * link points to (e.g. the PCI address `0000:03:00.0`) or the content of
+ * the `name` attribute (e.g. `amdgpu`).
+ * A name which is shared by several devices is ambiguous and cannot be
+ * resolved.
+ * Any other path is returned unchanged.
+ *
+ * Resolving scans the hwmon class directory at most once.
+ * The resulting map is cached in a file (usually in `/run`) such that
+ * a restart of the daemon does not need to scan again.
+ * The cache is stale if it has been written during a different boot or if
+ * a cached directory does not carry the expected identity anymore (e.g.
+ * after a driver has been reloaded); then the directory is scanned anew
+ * and the cache is rewritten.
+ */
+class HwmonResolver {
+	public:
+		static char const* const URI_PREFIX;
+		static char const* const SYSFS_HWMON_PATH;
+
+	public:
+		HwmonResolver( std::string const& hwmonPath, std::string const& cacheFilePath );
+		HwmonResolver( HwmonResolver const& ) = delete;
+		HwmonResolver& operator=( HwmonResolver const& ) = delete;
+
+	public:
+		std::string resolve( std::string const& path );
+		static bool isReference( std::string const& path );
+		/**
+		 * Indicates whether the hwmon directory has been scanned, i.e. whether
+		 * the cache has been missing or stale.
+		 */
+		bool hasScanned() const { return isScanned; };
+
+	private:
+		typedef std::map<std::string, std::string> IdentityMap;
+
+		void loadCache();
+		void writeCache() const;
+		void scan();
+		bool isValid( std::string const& identity, std::string const& dir ) const;
+		static std::string readAttribute( std::string const& filePath );
+		static std::string readDeviceName( std::string const& dir );
+
+	private:
+		std::string hwmonPath;
+		std::string cacheFilePath;
+		std::string bootId;
+		bool isLoaded;
+		bool isScanned;
+		IdentityMap directories;
+};
+
+}
+
+#endif
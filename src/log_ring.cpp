@@ -0,0 +1,160 @@
+#include "log_ring.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+#include <sched.h>
+#include <signal.h>
+#include <syslog.h>
+
+namespace AmdGpuFanControl {
+
+// Must be a power of two
+LogRing::size_type const LogRing::SLOT_COUNT = 64;
+
+/**
+ * C'tor.
+ *
+ * Allocates all slots and their message buffers upfront, but does not
+ * start the background thread yet.
+ *
+ * @param messageSize the maximum size of a message including the
+ * terminating `NUL`
+ */
+LogRing::LogRing( size_type const messageSize ) :
+	messageSize( messageSize ),
+	slots( new Slot[SLOT_COUNT] ),
+	messages( new char[SLOT_COUNT * messageSize] ),
+	enqueuePos( 0 ),
+	dequeuePos( 0 ),
+	dropped( 0 ),
+	reportedDropped( 0 ),
+	isRunning( false ),
+	pending(),
+	thread() {
+	for( size_type i = 0; i != SLOT_COUNT; i++ ) {
+		slots[i].sequence.store( i, std::memory_order_relaxed );
+		slots[i].severity = LOG_DEBUG;
+		slots[i].length = 0;
+		slots[i].message = messages.get() + i * messageSize;
+	}
+	if( sem_init( &pending, 0, 0 ) == -1 )
+		throw std::system_error( errno, std::generic_category(), "sem_init" );
+}
+
+/**
+ * D'tor.
+ *
+ * Stops the background thread after the ring has been drained.
+ */
+LogRing::~LogRing() {
+	stop();
+	sem_destroy( &pending );
+}
+
+/**
+ * Starts the background thread.
+ *
+ * All signals are blocked on the background thread such that signals
+ * are only received by the control thread, see `SignalReceiver`.
+ */
+void LogRing::start() {
+	if( isRunning.exchange( true ) ) return;
+	sigset_t all, previous;
+	sigfillset( &all );
+	pthread_sigmask( SIG_SETMASK, &all, &previous );
+	thread = std::thread( &LogRing::drain, this );
+	pthread_sigmask( SIG_SETMASK, &previous, nullptr );
+}
+
+/**
+ * Stops the background thread.
+ *
+ * All messages which have been pushed before are still passed to syslog.
+ */
+void LogRing::stop() {
+	if( !isRunning.exchange( false ) ) return;
+	sem_post( &pending );
+	thread.join();
+}
+
+/**
+ * Pushes a message into the ring.
+ *
+ * The method never blocks.
+ * Messages which are longer than the slots are truncated.
+ *
+ * @return `true` if the message has been queued, `false` if it has been
+ * dropped because the ring is full
+ */
+bool LogRing::push( int const severity, char const* message, size_type const length ) {
+	size_type pos = enqueuePos.load( std::memory_order_relaxed );
+	Slot* slot;
+	for(;;) {
+		slot = &slots[pos & ( SLOT_COUNT - 1 )];
+		size_type const sequence = slot->sequence.load( std::memory_order_acquire );
+		if( sequence == pos ) {
+			// The slot is free, try to claim it
+			if( enqueuePos.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+				break;
+		} else if( sequence < pos ) {
+			// The slot has not been consumed yet, i.e. the ring is full
+			dropped.fetch_add( 1, std::memory_order_relaxed );
+			return false;
+		} else {
+			// Another producer has claimed the slot in the meantime
+			pos = enqueuePos.load( std::memory_order_relaxed );
+		}
+	}
+
+	slot->severity = severity;
+	slot->length = std::min( length, messageSize - 1 );
+	std::memcpy( slot->message, message, slot->length );
+	slot->message[slot->length] = '\0';
+	slot->sequence.store( pos + 1, std::memory_order_release );
+	sem_post( &pending );
+	return true;
+}
+
+/**
+ * Passes the oldest message to syslog.
+ *
+ * Must only be called by the background thread.
+ *
+ * @return `false` if the ring is empty
+ */
+bool LogRing::pop() {
+	Slot& slot( slots[dequeuePos & ( SLOT_COUNT - 1 )] );
+	if( slot.sequence.load( std::memory_order_acquire ) != dequeuePos + 1 )
+		return false;
+	syslog( slot.severity, "%s", slot.message );
+	slot.sequence.store( dequeuePos + SLOT_COUNT, std::memory_order_release );
+	dequeuePos++;
+	return true;
+}
+
+void LogRing::drain() {
+	// Writing to syslog must never delay the control thread, even if it has
+	// started this thread in real-time mode, see `RealtimeMode`
+	sched_param const param = { 0 };
+	sched_setscheduler( 0, SCHED_OTHER, &param );
+	for(;;) {
+		while( sem_wait( &pending ) == -1 && errno == EINTR );
+		while( pop() );
+
+		unsigned long const d = dropped.load( std::memory_order_relaxed );
+		if( d != reportedDropped ) {
+			syslog( LOG_WARNING, "%lu log message(s) dropped", d - reportedDropped );
+			reportedDropped = d;
+		}
+
+		if( !isRunning.load() ) {
+			// Catch messages which have been pushed after the last `pop`
+			while( pop() );
+			return;
+		}
+	}
+}
+
+}
@@ -0,0 +1,79 @@
+#ifndef _LOG_RING_H_
+#define _LOG_RING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <semaphore.h>
+
+namespace AmdGpuFanControl {
+
+/**
+ * Passes log messages to syslog on a background thread.
+ *
+ * `syslog` blocks if the receiving end (e.g. journald) is backed up, and
+ * the thread which logs must not block while it controls the fans.
+ * Hence, in asynchronous mode, `LogBuffer` does not call `syslog` itself
+ * but pushes its message into this ring and a background thread drains the
+ * ring to syslog.
+ *
+ * The ring is a bounded multi-producer/single-consumer queue of
+ * `SLOT_COUNT` slots, each of which holds a message of up to
+ * `LogBuffer::LOG_BUFFER_SIZE` characters.
+ * All slots are allocated upfront.
+ * Pushing a message is lock-free and never blocks: if the ring is full, the
+ * message is dropped and counted.
+ * The background thread reports the number of dropped messages to syslog
+ * once it has caught up.
+ *
+ * @internal The queue follows the well-known design by D. Vyukov: each slot
+ * carries a sequence number which tells producers and the consumer whether
+ * the slot is free to be written or ready to be read.
+ */
+class LogRing {
+	public:
+		typedef std::size_t size_type;
+
+		static size_type const SLOT_COUNT;
+
+	private:
+		struct Slot {
+			std::atomic<size_type> sequence;
+			int severity;
+			size_type length;
+			char* message;
+		};
+
+	public:
+		LogRing( size_type const messageSize );
+		LogRing( LogRing const& ) = delete;
+		LogRing& operator=( LogRing const& ) = delete;
+		~LogRing();
+
+	public:
+		bool push( int const severity, char const* message, size_type const length );
+		void start();
+		void stop();
+		unsigned long getDropped() const { return dropped.load( std::memory_order_relaxed ); };
+
+	private:
+		bool pop();
+		void drain();
+
+	private:
+		size_type const messageSize;
+		std::unique_ptr<Slot[]> slots;
+		std::unique_ptr<char[]> messages;
+		std::atomic<size_type> enqueuePos;
+		size_type dequeuePos;
+		std::atomic<unsigned long> dropped;
+		unsigned long reportedDropped;
+		std::atomic<bool> isRunning;
+		sem_t pending;
+		std::thread thread;
+};
+
+}
+
+#endif
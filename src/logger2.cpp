@@ -18,7 +18,8 @@ LogBuffer::LogBuffer() :
 	allocator(),
 	buffer(allocator.allocate(LOG_BUFFER_SIZE)),
 	treshhold(DEFAULT_LOG_LEVEL),
-	severity(DEFAULT_LOG_LEVEL) {
+	severity(DEFAULT_LOG_LEVEL),
+	ring() {
 	init();
 	openlog( NULL, LOG_ODELAY, LOG_DAEMON );
 }
@@ -26,9 +27,11 @@ LogBuffer::LogBuffer() :
 /**
  * D'tor.
  *
- * Deallocates the internal buffer and closes the connection to syslog.
+ * Drains and stops the asynchronous ring (if any), deallocates the internal
+ * buffer and closes the connection to syslog.
  */
 LogBuffer::~LogBuffer() {
+	ring.reset();
 	allocator.deallocate(buffer, LOG_BUFFER_SIZE);
 	closelog();
 }
@@ -82,6 +85,8 @@ LogBuffer::pos_type LogBuffer::seekoff(
 			case std::ios_base::end:
 				newPPtr = epptr() + offset;
 				break;
+			default:
+				throw std::ios_base::failure("Invalid argument: Unknown seek direction");
 		}
 
 		if( newPPtr < pbase() )
@@ -126,6 +131,8 @@ LogBuffer::pos_type LogBuffer::seekoff(
 		case std::ios_base::end:
 			newGPtr = egptr() + offset;
 			break;
+		default:
+			throw std::ios_base::failure("Invalid argument: Unknown seek direction");
 	}
 
 	if( newGPtr < eback() )
@@ -145,12 +152,31 @@ int LogBuffer::sync() {
 		// put pointer `epptr` one less than the allocated size such that there
 		// is always one more character available even if the buffer is full.
 		*pptr() = '\0';
-		syslog( severity, "%s", pbase() );
+		if( ring )
+			ring->push( severity, pbase(), size() );
+		else
+			syslog( severity, "%s", pbase() );
 	}
 	init();
 	return SUCCESS;
 }
 
+/**
+ * Switches between synchronous and asynchronous mode.
+ *
+ * Switching to synchronous mode drains the ring and stops the background
+ * thread.
+ */
+void LogBuffer::setAsynchronous(bool const isAsync) {
+	if( isAsync == static_cast<bool>(ring) ) return;
+	if( isAsync ) {
+		ring.reset( new LogRing(LOG_BUFFER_SIZE) );
+		ring->start();
+	} else {
+		ring.reset();
+	}
+}
+
 LogBuffer::int_type LogBuffer::underflow() {
 	if( 0 == showmanyc()) {
 		return std::char_traits<char>::eof();
@@ -1,9 +1,11 @@
 #ifndef _LOGGER_2_H_
 #define _LOGGER_2_H_
 
+#include <memory>
 #include <ostream>
 #include <streambuf>
 #include <syslog.h>
+#include "log_ring.h"
 
 namespace AmdGpuFanControl {
 
@@ -69,6 +71,10 @@ class LogStream;
  * position of the current put pointer `pptr` and return the next character.
  * If this is impossible (because `egptr` has already reached `pptr`), then
  * `underflow` returns `EOF`.
+ *
+ * In asynchronous mode, `sync` does not call `syslog` itself, but pushes the
+ * message into a `LogRing` which is drained by a background thread, i.e.
+ * `sync` never blocks.
  */
 class LogBuffer : public std::streambuf {
 	friend class LogStream;
@@ -116,6 +122,16 @@ class LogBuffer : public std::streambuf {
 			severity = s;
 		}
 
+		bool isEnabled(LogBuffer::Severity const s) const {
+			return s <= treshhold;
+		}
+
+		void setAsynchronous(bool const isAsync);
+
+		unsigned long getDropped() const {
+			return ring ? ring->getDropped() : 0;
+		}
+
 	protected:
 		virtual pos_type seekoff(
 			off_type offset,
@@ -140,6 +156,7 @@ class LogBuffer : public std::streambuf {
 		char* buffer;
 		Severity treshhold;
 		Severity severity;
+		std::unique_ptr<LogRing> ring;
 };
 
 
@@ -179,6 +196,34 @@ class LogStream : public std::ostream {
 		void setSeverity(LogBuffer::Severity const s) {
 			logBuffer.setSeverity(s);
 		}
+		/**
+		 * Indicates whether a message of the given severity passes the
+		 * threshold and will actually be written to syslog.
+		 *
+		 * Use this (or `AMDGPU_FANCTRL_LOG`) to skip formatting a message which
+		 * would be discarded anyway.
+		 */
+		bool isEnabled(LogBuffer::Severity const s) const {
+			return logBuffer.isEnabled(s);
+		}
+		/**
+		 * Switches between synchronous and asynchronous mode.
+		 *
+		 * In asynchronous mode, messages are passed to syslog by a background
+		 * thread and are dropped (but counted) if the background thread
+		 * cannot keep up, see `LogRing`.
+		 */
+		void setAsynchronous(bool const isAsync) {
+			flush();
+			logBuffer.setAsynchronous(isAsync);
+		}
+		/**
+		 * Returns the number of messages which have been dropped in
+		 * asynchronous mode.
+		 */
+		unsigned long getDropped() const {
+			return logBuffer.getDropped();
+		}
 		LogStream& operator<<(LogBuffer::Severity const severity) {
 			setSeverity(severity);
 			return *this;
@@ -192,4 +237,23 @@ class LogStream : public std::ostream {
 
 }
 
+/**
+ * Starts a log message of the given severity on the given log stream, if
+ * the severity passes the threshold.
+ *
+ * If the severity does not pass the threshold, the entire remainder of the
+ * statement is skipped, i.e. a filtered message costs a single branch and
+ * none of its arguments is formatted (or even evaluated).
+ *
+ * Usage:
+ *
+ *     AMDGPU_FANCTRL_LOG( log, LogBuffer::Severity::DEBUG )
+ *         << "Temperature: " << temp << std::flush;
+ *
+ * Note, the expansion is a complete `if`/`else` statement such that the
+ * macro is safe to use as the body of an unbraced `if`.
+ */
+#define AMDGPU_FANCTRL_LOG( log, severity ) \
+	if( !(log).isEnabled( severity ) ) {} else (log) << (severity)
+
 #endif
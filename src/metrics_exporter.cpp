@@ -0,0 +1,242 @@
+#include "metrics_exporter.h"
+
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <locale>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <poll.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace AmdGpuFanControl {
+
+char const* const MetricsExporter::METRIC_PREFIX = "amdgpu_fanctrl_";
+
+namespace {
+
+/**
+ * Describes how a member of a metrics struct is rendered.
+ *
+ * `scale` converts the stored integer into the base unit of the metric,
+ * e.g. nanoseconds into seconds.
+ */
+template<typename T> struct MetricFamily {
+	char const* name;
+	char const* type;
+	char const* help;
+	MetricsExporter::Metric T::* metric;
+	double scale;
+};
+
+MetricFamily<MetricsExporter::ControllerMetrics> const CONTROLLER_FAMILIES[] = {
+	{ "temperature_celsius", "gauge", "Current temperature", &MetricsExporter::ControllerMetrics::temperature, 1e-3 },
+	{ "pwm", "gauge", "Current PWM value", &MetricsExporter::ControllerMetrics::pwmValue, 1.0 },
+	{ "pwm_writes_total", "counter", "PWM writes issued to the actuator", &MetricsExporter::ControllerMetrics::writesIssued, 1.0 },
+	{ "pwm_writes_elided_total", "counter", "PWM writes elided because the value was unchanged", &MetricsExporter::ControllerMetrics::writesElided, 1.0 },
+	{ "skipped_updates_total", "counter", "Cycles in which the temperature stayed within the hysteresis band", &MetricsExporter::ControllerMetrics::skippedUpdates, 1.0 },
+	{ "sensor_errors_total", "counter", "Failed readings of the temperature sensors of the controller", &MetricsExporter::ControllerMetrics::sensorErrors, 1.0 },
+	{ "pwm_write_errors_total", "counter", "Failed writes to the actuator", &MetricsExporter::ControllerMetrics::writeErrors, 1.0 },
+	{ "update_latency_seconds", "gauge", "Latency of the most recent controller update", &MetricsExporter::ControllerMetrics::updateLatency, 1e-9 },
+	{ "read_latency_seconds", "gauge", "Latency of the most recent temperature read", &MetricsExporter::ControllerMetrics::readLatency, 1e-9 },
+	{ nullptr, nullptr, nullptr, nullptr, 0.0 }
+};
+
+MetricFamily<MetricsExporter::LoopMetrics> const LOOP_FAMILIES[] = {
+	{ "cycles_total", "counter", "Control cycles", &MetricsExporter::LoopMetrics::cycles, 1.0 },
+	{ "last_cycle_latency_seconds", "gauge", "Latency of the most recent control cycle", &MetricsExporter::LoopMetrics::cycleLatency, 1e-9 },
+	{ "cycle_latency_seconds_total", "counter", "Accumulated latency of all control cycles", &MetricsExporter::LoopMetrics::cycleLatencySum, 1e-9 },
+	{ "scheduler_ticks_total", "counter", "Ticks of the scheduler", &MetricsExporter::LoopMetrics::ticks, 1.0 },
+	{ "scheduler_overruns_total", "counter", "Ticks which have been woken up after the next deadline", &MetricsExporter::LoopMetrics::overruns, 1.0 },
+	{ "scheduler_skipped_ticks_total", "counter", "Ticks which have been skipped due to overruns", &MetricsExporter::LoopMetrics::skippedTicks, 1.0 },
+	{ "scheduler_alarm_wakeups_total", "counter", "Wakeups due to temperature alarms", &MetricsExporter::LoopMetrics::alarmWakeups, 1.0 },
+	{ "scheduler_wakeup_latency_max_seconds", "gauge", "Worst latency of a tick behind its deadline", &MetricsExporter::LoopMetrics::maxWakeupLatency, 1e-9 },
+	{ nullptr, nullptr, nullptr, nullptr, 0.0 }
+};
+
+}
+
+MetricsExporter::MetricsExporter() :
+	socketPath(),
+	listenFd( -1 ),
+	stopFd( -1 ),
+	controllerIndices(),
+	controllers(),
+	loop(),
+	thread() {
+}
+
+MetricsExporter::~MetricsExporter() {
+	close();
+}
+
+/**
+ * Creates the socket and starts the background thread.
+ *
+ * The metrics of the i-th controller (see `getControllerMetrics`) are
+ * labelled with the i-th element of the indices.
+ * A stale socket file of a previous instance is removed.
+ * All signals are blocked on the background thread such that signals
+ * are only received by the control thread, see `SignalReceiver`.
+ */
+void MetricsExporter::open( std::string const& path, ControllerIdxSeq const& indices ) {
+	close();
+	sockaddr_un address;
+	std::memset( &address, 0, sizeof( address ) );
+	address.sun_family = AF_UNIX;
+	if( path.size() >= sizeof( address.sun_path ) )
+		throw std::invalid_argument( "Metrics socket path too long" );
+	std::memcpy( address.sun_path, path.c_str(), path.size() );
+
+	controllerIndices = indices;
+	controllers.reset( new ControllerMetrics[indices.size()]() );
+
+	listenFd = socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+	if( listenFd == -1 )
+		throw std::system_error( errno, std::generic_category(), "socket" );
+	unlink( path.c_str() );
+	if(
+		bind( listenFd, reinterpret_cast<sockaddr*>( &address ), sizeof( address ) ) == -1 ||
+		listen( listenFd, 4 ) == -1
+	) {
+		int const e = errno;
+		::close( listenFd );
+		listenFd = -1;
+		throw std::system_error( e, std::generic_category(), path );
+	}
+	socketPath = path;
+
+	stopFd = eventfd( 0, EFD_CLOEXEC );
+	if( stopFd == -1 ) {
+		int const e = errno;
+		close();
+		throw std::system_error( e, std::generic_category(), "eventfd" );
+	}
+
+	sigset_t all, previous;
+	sigfillset( &all );
+	pthread_sigmask( SIG_SETMASK, &all, &previous );
+	thread = std::thread( &MetricsExporter::serve, this );
+	pthread_sigmask( SIG_SETMASK, &previous, nullptr );
+}
+
+void MetricsExporter::close() {
+	if( thread.joinable() ) {
+		std::uint64_t const one = 1;
+		if( write( stopFd, &one, sizeof( one ) ) != sizeof( one ) ) {
+			// Cannot happen for an eventfd unless the counter overflows
+		}
+		thread.join();
+	}
+	if( stopFd != -1 ) ::close( stopFd );
+	if( listenFd != -1 ) {
+		::close( listenFd );
+		unlink( socketPath.c_str() );
+	}
+	stopFd = listenFd = -1;
+	socketPath.clear();
+}
+
+void MetricsExporter::serve() {
+	// Scrapes must never delay the control thread, even if it has started
+	// this thread in real-time mode, see `RealtimeMode`
+	sched_param const param = { 0 };
+	sched_setscheduler( 0, SCHED_OTHER, &param );
+	pollfd fds[2];
+	fds[0].fd = listenFd;
+	fds[0].events = POLLIN;
+	fds[1].fd = stopFd;
+	fds[1].events = POLLIN;
+	for(;;) {
+		// Note, this thread must not log as `LogStream` is owned by the control
+		// thread
+		if( poll( fds, 2, -1 ) == -1 ) {
+			if( errno == EINTR ) continue;
+			return;
+		}
+		if( fds[1].revents ) return;
+		if( !( fds[0].revents & POLLIN ) ) continue;
+		int const clientFd = accept4( listenFd, nullptr, nullptr, SOCK_CLOEXEC );
+		if( clientFd == -1 ) continue;
+		respond( clientFd );
+		::close( clientFd );
+	}
+}
+
+/**
+ * Consumes the request (if any) and sends the metrics.
+ *
+ * The request is not interpreted; any request is answered with the
+ * metrics.
+ * Timeouts guard against clients which neither send a request nor read
+ * the response.
+ */
+void MetricsExporter::respond( int const clientFd ) const {
+	timeval const timeout = { 1, 0 };
+	setsockopt( clientFd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof( timeout ) );
+	setsockopt( clientFd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof( timeout ) );
+
+	// Read until the end of the HTTP header, the end of the stream or the
+	// timeout
+	char request[1024];
+	std::size_t length = 0;
+	while( length != sizeof( request ) ) {
+		ssize_t const n = read( clientFd, request + length, sizeof( request ) - length );
+		if( n <= 0 ) break;
+		length += n;
+		if( length >= 4 && std::memcmp( request + length - 4, "\r\n\r\n", 4 ) == 0 ) break;
+		if( length >= 2 && std::memcmp( request + length - 2, "\n\n", 2 ) == 0 ) break;
+	}
+
+	std::string const body( render() );
+	std::ostringstream response;
+	response.imbue( std::locale::classic() );
+	response << "HTTP/1.0 200 OK\r\n"
+	         << "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+	         << "Content-Length: " << body.size() << "\r\n"
+	         << "Connection: close\r\n\r\n"
+	         << body;
+	std::string const data( response.str() );
+	for( std::size_t sent = 0; sent != data.size(); ) {
+		ssize_t const n = send( clientFd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL );
+		if( n <= 0 ) return;
+		sent += n;
+	}
+}
+
+std::string MetricsExporter::render() const {
+	std::ostringstream out;
+	out.imbue( std::locale::classic() );
+	// Scaled values need all significant digits of a double, otherwise an
+	// accumulated latency in seconds loses its sub-millisecond resolution
+	out << std::setprecision( std::numeric_limits<double>::max_digits10 );
+	for( auto const* f = CONTROLLER_FAMILIES; f->name != nullptr; f++ ) {
+		out << "# HELP " << METRIC_PREFIX << f->name << " " << f->help << "\n"
+		    << "# TYPE " << METRIC_PREFIX << f->name << " " << f->type << "\n";
+		for( std::size_t i = 0; i != controllerIndices.size(); i++ ) {
+			std::uint64_t const value = ( controllers[i].*( f->metric ) ).load( std::memory_order_relaxed );
+			out << METRIC_PREFIX << f->name << "{controller=\"" << controllerIndices[i] << "\"} ";
+			if( f->scale == 1.0 ) out << value; else out << value * f->scale;
+			out << "\n";
+		}
+	}
+	for( auto const* f = LOOP_FAMILIES; f->name != nullptr; f++ ) {
+		std::uint64_t const value = ( loop.*( f->metric ) ).load( std::memory_order_relaxed );
+		out << "# HELP " << METRIC_PREFIX << f->name << " " << f->help << "\n"
+		    << "# TYPE " << METRIC_PREFIX << f->name << " " << f->type << "\n"
+		    << METRIC_PREFIX << f->name << " ";
+		if( f->scale == 1.0 ) out << value; else out << value * f->scale;
+		out << "\n";
+	}
+	return out.str();
+}
+
+}
@@ -0,0 +1,100 @@
+#ifndef _METRICS_EXPORTER_H_
+#define _METRICS_EXPORTER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace AmdGpuFanControl {
+
+/**
+ * Serves metrics in the Prometheus text format on a Unix domain socket.
+ *
+ * Each connection receives a single HTTP/1.0 response with the current
+ * metrics and is closed afterwards, e.g.
+ * `curl --unix-socket /run/amdgpu-fanctrl.metrics http://localhost/metrics`.
+ *
+ * The control thread publishes the metric values into relaxed atomics
+ * which are owned by the exporter; it neither takes a lock nor waits for
+ * the background thread which serves the requests.
+ * Hence, a slow or stalled scrape never delays a control cycle.
+ * The flip side is that a scrape may observe values of two consecutive
+ * cycles; every single value is consistent though.
+ */
+class MetricsExporter {
+	public:
+		typedef std::atomic<std::uint64_t> Metric;
+		typedef std::vector<std::size_t> ControllerIdxSeq;
+
+		/**
+		 * Metrics of a single controller.
+		 *
+		 * Latencies are in nanoseconds, temperatures in m°C.
+		 */
+		struct alignas(64) ControllerMetrics {
+			Metric temperature;
+			Metric pwmValue;
+			Metric writesIssued;
+			Metric writesElided;
+			Metric skippedUpdates;
+			Metric sensorErrors;
+			Metric writeErrors;
+			Metric updateLatency;
+			Metric readLatency;
+		};
+
+		/**
+		 * Metrics of the control loop as a whole.
+		 */
+		struct alignas(64) LoopMetrics {
+			Metric cycles;
+			Metric cycleLatency;
+			Metric cycleLatencySum;
+			Metric ticks;
+			Metric overruns;
+			Metric skippedTicks;
+			Metric alarmWakeups;
+			Metric maxWakeupLatency;
+		};
+
+		static char const* const METRIC_PREFIX;
+
+	public:
+		MetricsExporter();
+		MetricsExporter( MetricsExporter const& ) = delete;
+		MetricsExporter& operator=( MetricsExporter const& ) = delete;
+		~MetricsExporter();
+
+	public:
+		void open( std::string const& socketPath, ControllerIdxSeq const& controllerIndices );
+		void close();
+		bool isOpen() const { return listenFd != -1; };
+		ControllerMetrics& getControllerMetrics( std::size_t const idx ) { return controllers[idx]; };
+		LoopMetrics& getLoopMetrics() { return loop; };
+
+		static void publish( Metric& metric, std::uint64_t const value ) {
+			metric.store( value, std::memory_order_relaxed );
+		};
+
+	private:
+		void serve();
+		void respond( int const clientFd ) const;
+		std::string render() const;
+
+	private:
+		std::string socketPath;
+		int listenFd;
+		int stopFd;
+		ControllerIdxSeq controllerIndices;
+		std::unique_ptr<ControllerMetrics[]> controllers;
+		LoopMetrics loop;
+		std::thread thread;
+};
+
+}
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef _PERFECT_HASH_H_
+#define _PERFECT_HASH_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+namespace AmdGpuFanControl {
+
+/**
+ * Maps a fixed set of strings onto their positions by a perfect hash
+ * function which is computed at compile time.
+ *
+ * The hash function is FNV-1a with a seed.
+ * The constructor searches for the first seed for which all keys fall into
+ * distinct slots of a table with `TABLE_SIZE` slots; each slot holds the
+ * position of its key or `NOT_FOUND`.
+ * Hence, a lookup hashes the key once, reads a single slot and compares
+ * a single string.
+ *
+ * The table is meant to be a `constexpr` object; if no seed is found
+ * (e.g. because of duplicate keys), the constructor throws and the
+ * initialization of the object fails to compile.
+ */
+template<std::size_t N> class PerfectHash {
+	public:
+		typedef std::array<std::string_view, N> KeySeq;
+
+		static constexpr std::size_t NOT_FOUND = N;
+		/**
+		 * The smallest power of two with at least four slots per key, which
+		 * keeps the search for a seed short.
+		 */
+		static constexpr std::size_t TABLE_SIZE = [] {
+			std::size_t size = 1;
+			while( size < 4 * N ) size *= 2;
+			return size;
+		}();
+		static constexpr std::uint32_t MAX_SEED = 1u << 16;
+
+		static_assert( N < 255, "Slots only hold 8-bit positions" );
+
+	public:
+		constexpr PerfectHash( KeySeq const& k ) :
+			keys( k ),
+			seed( 0 ),
+			slots() {
+			for( seed = 1; seed != MAX_SEED; seed++ ) {
+				if( tryFill() ) return;
+			}
+			throw std::logic_error( "No perfect hash function for the given keys" );
+		};
+
+	public:
+		/**
+		 * Returns the position of the key or `NOT_FOUND`.
+		 */
+		constexpr std::size_t find( std::string_view const key ) const {
+			std::size_t const pos = slots[hash( key, seed ) & ( TABLE_SIZE - 1 )];
+			return pos != NOT_FOUND && keys[pos] == key ? pos : NOT_FOUND;
+		};
+		constexpr std::uint32_t getSeed() const { return seed; };
+
+	private:
+		static constexpr std::uint32_t hash( std::string_view const key, std::uint32_t const s ) {
+			std::uint32_t h = 2166136261u ^ s;
+			for( char const c : key ) {
+				h ^= static_cast<unsigned char>( c );
+				h *= 16777619u;
+			}
+			return h;
+		};
+
+		constexpr bool tryFill() {
+			for( std::size_t i = 0; i != TABLE_SIZE; i++ ) slots[i] = NOT_FOUND;
+			for( std::size_t pos = 0; pos != N; pos++ ) {
+				std::uint8_t& slot( slots[hash( keys[pos], seed ) & ( TABLE_SIZE - 1 )] );
+				if( slot != NOT_FOUND ) return false;
+				slot = static_cast<std::uint8_t>( pos );
+			}
+			return true;
+		};
+
+	private:
+		KeySeq keys;
+		std::uint32_t seed;
+		std::array<std::uint8_t, TABLE_SIZE> slots;
+};
+
+}
+
+#endif
@@ -1,4 +1,10 @@
 #include "pwm_actuator.h"
+#include "temp_sensor.h"
+
+#include <cerrno>
+#include <system_error>
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace AmdGpuFanControl {
 
@@ -8,49 +14,136 @@ PWMActuator::PWMActuator(
 	std::string const& devFilePath
 ) :
 	filePath( devFilePath ),
-	fileStream() {
-	fileStream.exceptions( std::ofstream::failbit | std::ofstream::badbit );
-	fileStream.open( devFilePath );
-	setMode( PwmMode::USER_CONTROL );
+	valueFd( -1 ),
+	modeFd( -1 ),
+	currentValue( 0 ),
+	isCurrentValueKnown( false ),
+	consecutiveElisions( 0 ),
+	writesIssued( 0 ),
+	writesElided( 0 ) {
+	std::string const modeFilePath( filePath + MODE_FILE_SUFFIX );
+	modeFd = open( modeFilePath.c_str(), O_WRONLY | O_CLOEXEC );
+	if( modeFd == -1 )
+		throw std::system_error( errno, std::generic_category(), modeFilePath );
+	valueFd = open( filePath.c_str(), O_RDWR | O_CLOEXEC );
+	if( valueFd == -1 ) {
+		int const e = errno;
+		close( modeFd );
+		modeFd = -1;
+		throw std::system_error( e, std::generic_category(), filePath );
+	}
+
+	try {
+		setMode( PwmMode::USER_CONTROL );
+	} catch( std::system_error const& ) {
+		close( valueFd );
+		close( modeFd );
+		valueFd = modeFd = -1;
+		throw;
+	}
+
+	// Learn the value which the hardware holds in manual mode (the duty
+	// cycle of the automatic mode is meaningless afterwards) such that the
+	// first write can already be elided, if possible.
+	// The file has the same format as a temperature file.
+	char buffer[WRITE_BUFFER_SIZE];
+	ssize_t const n = pread( valueFd, buffer, WRITE_BUFFER_SIZE, 0 );
+	if( n > 0 ) {
+		isCurrentValueKnown =
+			TemperatureSensor::parseValue( buffer, buffer + n, currentValue ) ==
+			TemperatureSensor::Status::OK;
+	}
 }
 
 PWMActuator::PWMActuator( PWMActuator&& other ) :
 	filePath( std::move( other.filePath ) ),
-	fileStream( std::move( other.fileStream ) ) {
-	// Close the file streams of the object which has been moved from, to avoid
-	// that the PWM mode is accidentally set to `AUTO_CONTROL` when the object
-	// goes out-of-scope.
+	valueFd( other.valueFd ),
+	modeFd( other.modeFd ),
+	currentValue( other.currentValue ),
+	isCurrentValueKnown( other.isCurrentValueKnown ),
+	consecutiveElisions( other.consecutiveElisions ),
+	writesIssued( other.writesIssued ),
+	writesElided( other.writesElided ) {
+	// Invalidate the file descriptors of the object which has been moved from,
+	// to avoid that the PWM mode is accidentally set to `AUTO_CONTROL` when the
+	// object goes out-of-scope.
 	// See comment on PWMActuator::setMode.
-	other.fileStream.exceptions( std::ofstream::goodbit );
-	other.fileStream.close();
+	other.valueFd = -1;
+	other.modeFd = -1;
 }
 
 PWMActuator::~PWMActuator() {
-	setMode( PwmMode::AUTO_CONTROL );
-	fileStream.exceptions( std::ofstream::goodbit );
-	fileStream.close();
+	// Errors are ignored on purpose, there is nothing we could do about them
+	// while shutting down.
+	if( modeFd != -1 ) {
+		writeValue( modeFd, PwmMode::AUTO_CONTROL );
+		close( modeFd );
+	}
+	if( valueFd != -1 ) close( valueFd );
 }
 
 /**
  * Sets the operating mode of the PWM actuator.
  *
- * @internal This method has only an effect, if `filestream` is open.
+ * The driver may change the PWM value along with the mode, hence the value
+ * is not known anymore afterwards.
+ *
+ * @internal This method has only an effect, if `modeFd` is open.
  * This prevents that the PWM mode is unintentionally set to `AUTO` when an
  * object instance upon which the move-constructor has been called goes
  * out-of-scope.
  */
-void PWMActuator::setMode( PwmMode const pwmMode ) const {
-	if ( !fileStream.is_open() ) return;
-
-	std::ofstream fs;
-	fs.exceptions( std::ofstream::failbit | std::ofstream::badbit );
-	fs.open( filePath + MODE_FILE_SUFFIX );
-	fs << pwmMode << std::endl;
-	fs.close();
+void PWMActuator::setMode( PwmMode const pwmMode ) {
+	if ( modeFd == -1 ) return;
+	isCurrentValueKnown = false;
+	if( !writeValue( modeFd, pwmMode ) )
+		throw std::system_error( errno, std::generic_category(), filePath + MODE_FILE_SUFFIX );
 }
 
-void PWMActuator::setValue( PwmValue const pwmValue ) {
-	fileStream << pwmValue << std::endl << std::flush;
+/**
+ * Writes the PWM value unless the hardware already holds it.
+ *
+ * The hardware may lose the value behind the back of the actuator (e.g. by
+ * a reset of the GPU or a write of another process), hence an unchanged
+ * value is written anyway after `MAX_CONSECUTIVE_ELISIONS` elided writes.
+ *
+ * @return zero on success, otherwise the error number of the failed write;
+ * the hardware holds an unknown value then
+ */
+int PWMActuator::setValue( PwmValue const pwmValue ) {
+	if( isCurrentValueKnown && pwmValue == currentValue && consecutiveElisions < MAX_CONSECUTIVE_ELISIONS ) {
+		writesElided++;
+		consecutiveElisions++;
+		return 0;
+	}
+	writesIssued++;
+	consecutiveElisions = 0;
+	if( !writeValue( valueFd, pwmValue ) ) {
+		isCurrentValueKnown = false;
+		return errno;
+	}
+	currentValue = pwmValue;
+	isCurrentValueKnown = true;
+	return 0;
+}
+
+/**
+ * Formats an unsigned integer followed by a newline and writes it with
+ * a single `pwrite` at offset zero.
+ *
+ * @return `true` on success; otherwise `errno` is set
+ */
+bool PWMActuator::writeValue( int const fd, unsigned int const value ) {
+	char buffer[WRITE_BUFFER_SIZE];
+	char* p = buffer + WRITE_BUFFER_SIZE;
+	*--p = '\n';
+	unsigned int v = value;
+	do {
+		*--p = '0' + v % 10;
+		v /= 10;
+	} while( v != 0 );
+	std::size_t const n = buffer + WRITE_BUFFER_SIZE - p;
+	return pwrite( fd, p, n, 0 ) == static_cast<ssize_t>( n );
 }
 
 }
@@ -2,7 +2,7 @@
 #define _PWM_ACTUATOR_H_
 
 #include "types.h"
-#include <fstream>
+#include <cstddef>
 #include <string>
 #include <memory>
 
@@ -10,6 +10,26 @@ namespace AmdGpuFanControl {
 
 class PWMActuatorFactory;
 
+/**
+ * Writes the PWM value to a hwmon `pwm*` file.
+ *
+ * The class keeps both the value file (e.g. `pwm1`) and the mode file
+ * (e.g. `pwm1_enable`) open as raw file descriptors for its entire
+ * lifetime.
+ * A value is formatted into a small buffer on the stack and written with
+ * exactly one `pwrite`.
+ *
+ * The class remembers the value the hardware currently holds (initially,
+ * the value is read back from the device) and elides a write if the new
+ * value equals the current one; see `setValue` for when the value is
+ * written nevertheless.
+ * The number of issued and elided writes is counted.
+ *
+ * Only the constructor throws; a failed write (e.g. while the GPU is
+ * reset) is reported by the return value of `setValue`, such that it
+ * neither affects other actuators nor skips the destructor, which hands
+ * the fan back to the automatic mode.
+ */
 class PWMActuator {
 	friend class PWMActuatorFactory;
 
@@ -23,6 +43,23 @@ class PWMActuator {
 		};
 		typedef std::shared_ptr<PWMActuator> Ptr;
 
+		/**
+		 * The largest PWM value of the hwmon ABI (i.e. full speed).
+		 */
+		static constexpr PwmValue MAX_PWM_VALUE = 255;
+
+		/**
+		 * Size of the write buffer on the stack; sufficient for any unsigned
+		 * integer in decimal notation plus a newline.
+		 */
+		static constexpr std::size_t WRITE_BUFFER_SIZE = 16;
+
+		/**
+		 * Number of consecutive elided writes after which an unchanged value
+		 * is written again.
+		 */
+		static constexpr unsigned long MAX_CONSECUTIVE_ELISIONS = 60;
+
 	protected:
 		PWMActuator( std::string const& devFilePath );
 		PWMActuator( PWMActuator const& ) = delete;
@@ -30,14 +67,24 @@ class PWMActuator {
 	public:
 		PWMActuator( PWMActuator&& other );
 		virtual ~PWMActuator();
-		void setValue( PwmValue const pwmValue );
+		int setValue( PwmValue const pwmValue );
+		std::string const& getFilePath() const { return filePath; };
+		unsigned long getWritesIssued() const { return writesIssued; };
+		unsigned long getWritesElided() const { return writesElided; };
 
 	private:
-		void setMode( PwmMode const pwmMode ) const;
+		void setMode( PwmMode const pwmMode );
+		static bool writeValue( int const fd, unsigned int const value );
 
 	private:
 		std::string filePath;
-		std::ofstream fileStream;
+		int valueFd;
+		int modeFd;
+		PwmValue currentValue;
+		bool isCurrentValueKnown;
+		unsigned long consecutiveElisions;
+		unsigned long writesIssued;
+		unsigned long writesElided;
 };
 }
 
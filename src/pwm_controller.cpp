@@ -1,76 +1,318 @@
 #include "pwm_controller.h"
 #include "logger2.h"
 
-#include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 
 namespace AmdGpuFanControl {
 
-unsigned int const PWMController::INITIAL_TEMPERATURE( std::numeric_limits<Temperature>::min() );
-unsigned int const PWMController::INITIAL_PWM_VALUE( std::numeric_limits<PwmValue>::max() );
+char const* const PWMController::STAGE_NAMES[STAGE_COUNT] = { "read", "calc", "write", "log" };
 
-PWMController::PWMController( TemperatureSensor::Ptr const& s, PWMActuator::Ptr const& a ) :
-	config( RuntimeConfig::get() ),
-	lastTemperature( INITIAL_TEMPERATURE ),
-	lastPwmValue( INITIAL_PWM_VALUE ),
-	hasJustStartedSpinning( false ),
-	sensor( s ),
-	actuator( a ) {
+PWMController::PWMController(
+	RuntimeConfig::ControllerConfig const& c,
+	RuntimeConfig::ControllerConfigIdx const idx,
+	TemperatureInput const& i,
+	PWMActuator::Ptr const& a,
+	ControllerBatch& b,
+	Duration const maxInterval
+) :
+	config( c ),
+	index( idx ),
+	batch( b ),
+	lane( b.addLane( c ) ),
+	filter( c.createTemperatureFilter() ),
+	input( i ),
+	actuator( a ),
+	lastCycle(),
+	skippedUpdates( 0 ),
+	sensorErrors( 0 ),
+	failedSensors( i.getSensors().size(), false ),
+	writeErrors( 0 ),
+	isActuatorFailed( false ),
+	histograms(),
+	maxPidInterval( maxInterval ),
+	hasPidState( false ),
+	pidIntegral( 0.0 ),
+	pidLastTemperature( 0 ),
+	pidLastTime(),
+	hasOverride( false ),
+	overridePwmValue( 0 ),
+	overrideEnd() {
 }
 
-void PWMController::update() {
+/**
+ * Pins the PWM value until the given point in time; any previous override
+ * is replaced.
+ *
+ * The PID state is discarded, because the PID loop does not see the
+ * temperature response to the pinned value.
+ */
+void PWMController::setOverride( PwmValue const pwmValue, Clock::time_point const until ) {
+	hasOverride = true;
+	overridePwmValue = pwmValue;
+	overrideEnd = until;
+	hasPidState = false;
+}
+
+/**
+ * Ends an override before it expires.
+ */
+void PWMController::clearOverride() {
+	hasOverride = false;
+	hasPidState = false;
+}
+
+/**
+ * Hands the most recently acquired temperature over to the batch.
+ *
+ * The temperatures of all sensors are aggregated and pass the noise
+ * filter; if all readings have failed, nothing is fed into the filter.
+ * Must be called for each controller of the batch before
+ * `ControllerBatch::evaluate`.
+ */
+void PWMController::prepare() {
+	Temperature t;
+	if( !input.aggregate( t ) ) return;
+	batch.setTemperature( lane, filter.apply( t ) );
+}
+
+/**
+ * Runs one control cycle for a single controller.
+ *
+ * Only meant for a controller which does not share its batch with other
+ * controllers, e.g. for benchmarks; otherwise see `prepare` and `apply`.
+ *
+ * @return see `apply`
+ */
+bool PWMController::update() {
+	prepare();
+	Clock::time_point const calcStart = Clock::now();
+	batch.evaluate();
+	return apply( Clock::now() - calcStart );
+}
+
+/**
+ * Completes one control cycle after the batch has been evaluated.
+ *
+ * The latency of each stage of the cycle is recorded, see `Stage`.
+ *
+ * @param calcLatency the latency of `ControllerBatch::evaluate`
+ * @return `false` if the temperature has stayed within the hysteresis band
+ * or, in PID mode, if the PWM value has not changed (i.e. the controller
+ * has been idle); `true` otherwise
+ */
+bool PWMController::apply( Latency const calcLatency ) {
 	LogStream& log( LogStream::get() );
-	log << LogBuffer::Severity::DEBUG;
+	Clock::time_point const start = Clock::now();
+
+	Temperature const temp = batch.getTemperature( lane );
+	PwmValue const lastPwmValue = batch.getLastPwmValue( lane );
+	lastCycle.temperature = temp;
+	lastCycle.calculatedPwmValue = lastPwmValue;
+	lastCycle.pwmValue = lastPwmValue;
+	lastCycle.isUpdateNeeded = false;
+	lastCycle.isSensorOk = input.isOk();
+	lastCycle.readLatency = input.getReadLatency();
+	lastCycle.writeLatency = Latency::zero();
+	histograms[Stage::READ].record( lastCycle.readLatency );
 
-	Temperature const temp = sensor->getValue();
-	log << "Previous temperature: " << lastTemperature << " °mC; current temperature: " << temp << " °mC" << std::flush;
+	// A failed sensor is left out of the aggregation; the cycle is only
+	// skipped if all sensors have failed.
+	// Each failed reading is counted, but only changes are logged.
+	TemperatureInput::SensorSeq const& sensors( input.getSensors() );
+	for( std::size_t i = 0; i != sensors.size(); i++ ) {
+		bool const isFailed = sensors[i]->getStatus() != TemperatureSensor::Status::OK;
+		if( isFailed ) sensorErrors++;
+		if( isFailed == failedSensors[i] ) continue;
+		failedSensors[i] = isFailed;
+		if( isFailed ) {
+			log << LogBuffer::Severity::WARNING
+			    << "Could not read temperature from " << sensors[i]->getFilePath()
+			    << ( lastCycle.isSensorOk ? "; ignoring sensor" : "; skipping control cycle" ) << std::flush;
+		} else {
+			log << LogBuffer::Severity::NOTICE
+			    << "Temperature of " << sensors[i]->getFilePath() << " readable again" << std::flush;
+		}
+	}
+	if( !lastCycle.isSensorOk ) {
+		histograms[Stage::LOG].record( Clock::now() - start );
+		return true;
+	}
+	if( hasOverride && start >= overrideEnd ) {
+		clearOverride();
+		log << LogBuffer::Severity::NOTICE
+		    << "PWM override of " << actuator->getFilePath() << " has expired" << std::flush;
+	}
+	if( hasOverride ) {
+		// The override is committed as a forced update, such that the cycle
+		// after the override updates the fan regardless of the hysteresis
+		histograms[Stage::CALC].record( calcLatency );
+		lastCycle.isUpdateNeeded = true;
+		lastCycle.calculatedPwmValue = overridePwmValue;
+		Clock::time_point const writeStart = Clock::now();
+		histograms[Stage::LOG].record( writeStart - start );
+		int const error = actuator->setValue( overridePwmValue );
+		lastCycle.writeLatency = Clock::now() - writeStart;
+		histograms[Stage::WRITE].record( lastCycle.writeLatency );
+		if( !checkWrite( error ) ) return true;
+		lastCycle.pwmValue = overridePwmValue;
+		batch.commit( lane, temp, overridePwmValue, true );
+		return overridePwmValue != lastPwmValue;
+	}
+	AMDGPU_FANCTRL_LOG( log, LogBuffer::Severity::DEBUG )
+		<< "Previous temperature: " << batch.getLastTemperature( lane ) << " °mC; current temperature: " << temp << " °mC" << std::flush;
+	bool const isPid = config.getControlMode() == RuntimeConfig::ControllerConfig::ControlMode::PID;
+	if( !isPid && !batch.isUpdateNeeded( lane ) ) {
+		histograms[Stage::CALC].record( calcLatency );
+		skippedUpdates++;
+		AMDGPU_FANCTRL_LOG( log, LogBuffer::Severity::DEBUG )
+			<< "No setting update for this control cycle needed" << std::flush;
+		histograms[Stage::LOG].record( Clock::now() - start );
+		return false;
+	}
 
-	if( !needsUpdate(temp) ) {
-		log << "No setting update for this control cycle needed" << std::flush;
-		return;
+	PwmValue pwmValue = batch.getCalculatedPwmValue( lane );
+	Latency pidLatency( Latency::zero() );
+	if( isPid ) {
+		Clock::time_point const pidStart = Clock::now();
+		pwmValue = calcPidValue( temp, pwmValue, lastPwmValue, start );
+		pidLatency = Clock::now() - pidStart;
+	}
+	histograms[Stage::CALC].record( calcLatency + pidLatency );
+	if( isPid && pwmValue == lastPwmValue ) {
+		skippedUpdates++;
+		AMDGPU_FANCTRL_LOG( log, LogBuffer::Severity::DEBUG )
+			<< "PID output unchanged at " << pwmValue << std::flush;
+		histograms[Stage::LOG].record( Clock::now() - start - pidLatency );
+		return false;
 	}
 
-	PwmValue pwmValue = calcPwmValue(temp);
-	log << "Previous PWM value: " << lastPwmValue << "; calculated PWM value: " << pwmValue << std::flush;
+	lastCycle.isUpdateNeeded = true;
+	lastCycle.calculatedPwmValue = pwmValue;
+	AMDGPU_FANCTRL_LOG( log, LogBuffer::Severity::DEBUG )
+		<< "Previous PWM value: " << lastPwmValue << "; calculated PWM value: " << pwmValue << std::flush;
 
 	// If the actuator transits from "off" to "on", the next PWM value must be
 	// at least `getBaseControlPoint().pwmValue` to ensure that the fan savely
 	// starts spinning for DC controlled fans.
+	bool hasJustStartedSpinning = false;
 	if (lastPwmValue == 0 && pwmValue != 0) {
 		pwmValue = std::max(pwmValue, config.getBaseControlPoint().pwmValue);
 		hasJustStartedSpinning = true;
-		log << "Fan starts spinning; new PWM value: " << pwmValue << std::flush;
-	} else {
-		hasJustStartedSpinning = false;
+		AMDGPU_FANCTRL_LOG( log, LogBuffer::Severity::DEBUG )
+			<< "Fan starts spinning; new PWM value: " << pwmValue << std::flush;
 	}
 
-	actuator->setValue(pwmValue);
-	lastTemperature = temp;
-	lastPwmValue = pwmValue;
+	Clock::time_point const writeStart = Clock::now();
+	Latency const logLatency( writeStart - start - pidLatency );
+	int const error = actuator->setValue( pwmValue );
+	lastCycle.writeLatency = Clock::now() - writeStart;
+	histograms[Stage::WRITE].record( lastCycle.writeLatency );
+	histograms[Stage::LOG].record( logLatency );
+	// Nothing is committed if the write has failed, such that the next cycle
+	// tries again
+	if( !checkWrite( error ) ) return true;
+
+	lastCycle.pwmValue = pwmValue;
+	batch.commit( lane, temp, pwmValue, hasJustStartedSpinning );
+	return true;
 }
 
-bool PWMController::needsUpdate(unsigned int temperature) const {
-	return
-		( temperature > lastTemperature + config.getUpwardTemperatureHysteresis() ) ||
-		( temperature + config.getDownwardTemperatureHysteresis() < lastTemperature ) ||
-		hasJustStartedSpinning ||
-		lastTemperature == INITIAL_TEMPERATURE ||
-		lastPwmValue == INITIAL_PWM_VALUE;
+/**
+ * Counts a failed write and logs when the actuator fails or recovers.
+ *
+ * @param error the result of `PWMActuator::setValue`
+ * @return `true` if the write has succeeded
+ */
+bool PWMController::checkWrite( int const error ) {
+	bool const isFailed = error != 0;
+	if( isFailed ) writeErrors++;
+	if( isFailed != isActuatorFailed ) {
+		isActuatorFailed = isFailed;
+		LogStream& log( LogStream::get() );
+		if( isFailed ) {
+			log << LogBuffer::Severity::ERROR
+			    << "Could not write PWM value to " << actuator->getFilePath()
+			    << " (" << std::strerror( error ) << ")" << std::flush;
+		} else {
+			log << LogBuffer::Severity::NOTICE
+			    << "PWM value of " << actuator->getFilePath() << " writable again" << std::flush;
+		}
+	}
+	return !isFailed;
 }
 
-PwmValue PWMController::calcPwmValue( Temperature temperature ) const {
-	ControlPoint const& bCP( config.getBaseControlPoint() );
-	ControlPoint const& lCP( config.getLowControlPoint() );
-	ControlPoint const& hCP( config.getHighControlPoint() );
-
-	if( temperature < bCP.temp )
-		return 0;
-	if( temperature < lCP.temp )
-		return lCP.pwmValue;
-	if( temperature < hCP.temp ) {
-		float const slope = (float)(hCP.pwmValue - lCP.pwmValue) / (float)(hCP.temp - lCP.temp);
-		return slope * (float)(temperature - lCP.temp) + lCP.pwmValue;
+/**
+ * Computes the PWM value in PID mode.
+ *
+ * The output is the sum of the feed-forward value (the PWM value of the
+ * fan curve) and the proportional, integral and derivative terms of the
+ * temperature error relative to the target temperature.
+ * The output is limited to the range of the fan curve and its change per
+ * second is limited to the slew rate.
+ * The integral term is clamped to the same range and, as anti-windup, it
+ * is not accumulated while the output is limited in the direction of the
+ * error.
+ * Changes smaller than the output hysteresis are suppressed, unless the
+ * output reaches either end of the range.
+ * The time base is the time between two calls, such that the gains do not
+ * depend on the (possibly adaptive) control interval.
+ * It is capped at the maximum control interval, such that a gap (e.g.
+ * while all sensors have failed) does not let the integral jump.
+ * The first call after the state has been discarded (e.g. by an override)
+ * is not limited by the slew rate, as there is no time base yet.
+ */
+PwmValue PWMController::calcPidValue(
+	Temperature const temp,
+	PwmValue const feedForward,
+	PwmValue const lastPwmValue,
+	Clock::time_point const now
+) {
+	bool const isContinued = hasPidState;
+	double const dt = isContinued ? std::min(
+		std::chrono::duration<double>( now - pidLastTime ).count(),
+		std::chrono::duration<double>( maxPidInterval ).count()
+	) : 0.0;
+	double const error = ( static_cast<double>( temp ) - config.getPidTargetTemperature() ) / 1000.0;
+	double const derivative = dt > 0.0 ?
+		( static_cast<double>( temp ) - pidLastTemperature ) / 1000.0 / dt : 0.0;
+	hasPidState = true;
+	pidLastTemperature = temp;
+	pidLastTime = now;
+
+	double const maxPwmValue = config.getCurve().getMaxPwmValue();
+	double const integral = std::clamp(
+		pidIntegral + config.getPidIntegralGain() * error * dt, -maxPwmValue, maxPwmValue
+	);
+	double const output = feedForward +
+		config.getPidProportionalGain() * error +
+		integral +
+		config.getPidDerivativeGain() * derivative;
+
+	double limited = output;
+	if( isContinued && lastPwmValue != ControllerBatch::INITIAL_PWM_VALUE ) {
+		double const maxStep = config.getPidSlewRate() * dt;
+		limited = std::min( std::max( limited, lastPwmValue - maxStep ), lastPwmValue + maxStep );
 	}
-	return hCP.pwmValue;
+	limited = std::min( std::max( limited, 0.0 ), maxPwmValue );
+
+	bool const isWindingUp = ( output > limited && error > 0.0 ) || ( output < limited && error < 0.0 );
+	if( !isWindingUp ) pidIntegral = integral;
+
+	LogStream& log( LogStream::get() );
+	AMDGPU_FANCTRL_LOG( log, LogBuffer::Severity::DEBUG )
+		<< "PID error: " << error << " K; integral: " << pidIntegral
+		<< "; output: " << output << "; limited output: " << limited << std::flush;
+	PwmValue const pwmValue = static_cast<PwmValue>( std::lround( limited ) );
+	if(
+		lastPwmValue != ControllerBatch::INITIAL_PWM_VALUE &&
+		pwmValue != 0 && pwmValue != config.getCurve().getMaxPwmValue() &&
+		std::abs( limited - lastPwmValue ) < config.getPidOutputHysteresis()
+	)
+		return lastPwmValue;
+	return pwmValue;
 }
 
 }
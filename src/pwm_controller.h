@@ -3,29 +3,144 @@
 
 #include "runtime_config.h"
 #include "pwm_actuator.h"
-#include "temp_sensor.h"
+#include "temp_input.h"
+#include "histogram.h"
+#include "controller_batch.h"
+#include "temp_filter.h"
+#include <chrono>
+#include <vector>
 
 namespace AmdGpuFanControl {
+/**
+ * Controls a PWM actuator based on the temperature of one or more sensors.
+ *
+ * The numeric state of the controller lives in a lane of a
+ * `ControllerBatch` which may be shared with other controllers.
+ * A cycle consists of `prepare` for each controller, a single
+ * `ControllerBatch::evaluate` for all of them and `apply` for each
+ * controller; `update` runs all three steps for a single controller.
+ *
+ * In PID mode (see `RuntimeConfig::ControllerConfig::ControlMode`) the
+ * controller ignores the hysteresis and adds the output of a PID loop to
+ * the PWM value of the fan curve.
+ *
+ * The PWM value may temporarily be overridden by a fixed value, see
+ * `setOverride`; the override ends by itself at the given point in time
+ * and the next cycle then updates the fan regardless of the hysteresis.
+ */
 class PWMController {
-	private:
-		static Temperature const INITIAL_TEMPERATURE;
-		static PwmValue const INITIAL_PWM_VALUE;
+	public:
+		typedef std::chrono::steady_clock Clock;
+
+		/**
+		 * Describes the most recent control cycle of a controller.
+		 *
+		 * If the cycle did not need an update, `calculatedPwmValue` equals
+		 * the unchanged `pwmValue` and `writeLatency` is zero.
+		 */
+		struct Cycle {
+			Temperature temperature;
+			PwmValue calculatedPwmValue;
+			PwmValue pwmValue;
+			bool isUpdateNeeded;
+			bool isSensorOk;
+			Latency readLatency;
+			Latency writeLatency;
+		};
+
+		/**
+		 * The stages of a control cycle for which latencies are recorded.
+		 *
+		 * `READ` is the latency of acquiring the temperature, `CALC` covers
+		 * the evaluation of the batch (which is shared among all controllers
+		 * of the batch) and the PID loop, `WRITE` covers the actuator and
+		 * `LOG` covers the time spent on logging within `apply`.
+		 */
+		enum Stage : unsigned short {
+			READ = 0,
+			CALC = 1,
+			WRITE = 2,
+			LOG = 3,
+			STAGE_COUNT = 4
+		};
+
+		static char const* const STAGE_NAMES[STAGE_COUNT];
 
 	public:
-		PWMController( TemperatureSensor::Ptr const& s, PWMActuator::Ptr const& a );
-		void update();
+		PWMController(
+			RuntimeConfig::ControllerConfig const& c,
+			RuntimeConfig::ControllerConfigIdx const idx,
+			TemperatureInput const& i,
+			PWMActuator::Ptr const& a,
+			ControllerBatch& b,
+			Duration const maxInterval
+		);
+		void prepare();
+		bool apply( Latency const calcLatency );
+		bool update();
+		Cycle const& getLastCycle() const { return lastCycle; };
+		/**
+		 * Returns the number of cycles in which the temperature has stayed
+		 * within the hysteresis band such that no update was needed.
+		 */
+		unsigned long getSkippedUpdates() const { return skippedUpdates; };
+		/**
+		 * Returns the number of failed readings of all sensors of the input.
+		 */
+		unsigned long getSensorErrors() const { return sensorErrors; };
+		/**
+		 * Returns the number of failed writes to the actuator.
+		 */
+		unsigned long getWriteErrors() const { return writeErrors; };
+		PWMActuator const& getActuator() const { return *actuator; };
+		RuntimeConfig::ControllerConfig const& getConfig() const { return config; };
+		/**
+		 * Returns the index of the controller in the configuration, which
+		 * identifies the controller towards the user (administration,
+		 * telemetry, metrics) even if a preceding controller is disabled.
+		 */
+		RuntimeConfig::ControllerConfigIdx getIndex() const { return index; };
+		void setOverride( PwmValue const pwmValue, Clock::time_point const until );
+		void clearOverride();
+		bool isOverridden() const { return hasOverride; };
+		PwmValue getOverridePwmValue() const { return overridePwmValue; };
+		Clock::time_point getOverrideEnd() const { return overrideEnd; };
+		LatencyHistogram const& getHistogram( Stage const stage ) const {
+			return histograms[stage];
+		};
 
 	private:
-		bool needsUpdate( Temperature temperature ) const;
-		PwmValue calcPwmValue( Temperature temperature ) const;
+		bool checkWrite( int const error );
+		PwmValue calcPidValue( Temperature const temp, PwmValue const feedForward, PwmValue const lastPwmValue, Clock::time_point const now );
 
 	private:
-		RuntimeConfig const& config;
-		Temperature lastTemperature;
-		PwmValue lastPwmValue;
-		bool hasJustStartedSpinning;
-		TemperatureSensor::Ptr sensor;
+		RuntimeConfig::ControllerConfig const& config;
+		RuntimeConfig::ControllerConfigIdx index;
+		ControllerBatch& batch;
+		ControllerBatch::Lane lane;
+		TemperatureFilter filter;
+		TemperatureInput input;
 		PWMActuator::Ptr actuator;
+		Cycle lastCycle;
+		unsigned long skippedUpdates;
+		unsigned long sensorErrors;
+		// Whether the most recent reading of each sensor has failed, such that
+		// a permanently failed sensor is only reported once
+		std::vector<bool> failedSensors;
+		unsigned long writeErrors;
+		// Whether the most recent write has failed, see `failedSensors`
+		bool isActuatorFailed;
+		LatencyHistogram histograms[STAGE_COUNT];
+		// State of the PID mode
+		Duration maxPidInterval;
+		bool hasPidState;
+		double pidIntegral;
+		Temperature pidLastTemperature;
+		Clock::time_point pidLastTime;
+		// State of an override
+		bool hasOverride;
+		PwmValue overridePwmValue;
+		Clock::time_point overrideEnd;
 };
 }
 
@@ -5,30 +5,618 @@
 #include "pwm_actuator.h"
 #include "pwm_actuator_factory.h"
 #include "logger2.h"
+#include "hwmon_resolver.h"
 
+#include <algorithm>
 #include <chrono>
-#include <thread>
+#include <cstring>
+#include <iomanip>
+#include <locale>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <signal.h>
 
 namespace AmdGpuFanControl {
 
+std::size_t const PWMControllers::MAX_DUMP_RECORDS( 1024 );
+
 PWMControllers::PWMControllers() :
-	config( RuntimeConfig::get() ),
 	runState( RunState::STOPPED ),
-	temperatureSensors(),
-	pwmActuators(),
-	pwmControllers() {
+	signals(),
+	setup(),
+	acquisition(),
+	scheduler(),
+	telemetry(),
+	metrics(),
+	configWatcher(),
+	admin(),
+	adminRequests(),
+	realtime(),
+	acquisitionHistogram(),
+	cycleHistogram(),
+	isStatisticsRequested( false ),
+	isReloadRequested( false ) {
+	RuntimeConfig::Ptr const config( RuntimeConfig::getCurrent() );
+	if( !config )
+		throw std::logic_error( "No configuration has been published" );
+	signals.open( { SIGHUP, SIGINT, SIGQUIT, SIGTERM, SIGTSTP, SIGUSR1 } );
+	scheduler.addEventFd( signals.getFd() );
+	adminRequests.reserve( AdminServer::MAX_CLIENTS );
+	activate( createSetup( config ) );
+}
+
+/**
+ * Builds the controllers of a configuration snapshot.
+ *
+ * Controllers whose configuration is invalid are disabled, i.e. the result
+ * may contain fewer controllers than the configuration or none at all.
+ */
+std::unique_ptr<PWMControllers::Setup> PWMControllers::createSetup( RuntimeConfig::Ptr const& config ) {
+	LogStream& log( LogStream::get() );
 	TemperatureSensorFactory& temperatureSensorFactory( TemperatureSensorFactory::get() );
 	PWMActuatorFactory& pwmActuatorFactory( PWMActuatorFactory::get() );
+	std::unique_ptr<Setup> next( new Setup() );
+	next->config = config;
+	TemperatureSensorCollection& temperatureSensors( next->temperatureSensors );
+	PWMActuatorCollection& pwmActuators( next->pwmActuators );
+	PWMControllerCollection& pwmControllers( next->pwmControllers );
+	RuntimeConfig::TemperatureSensorPathSeq const& sensorPaths( config->getTemperatureSensorPathSeq() );
+	RuntimeConfig::PwmActuatorPathSeq const& actuatorPaths( config->getPwmActuatorPathSeq() );
+	RuntimeConfig::ControllerConfigSeq const& controllerConfigs( config->getControllerConfigSeq() );
+	HwmonResolver hwmonResolver( HwmonResolver::SYSFS_HWMON_PATH, config->getHwmonCacheFilePath() );
+	auto resolve = [&log, &hwmonResolver]( std::string const& path ) {
+		if( !HwmonResolver::isReference( path ) ) return path;
+		std::string const resolvedPath( hwmonResolver.resolve( path ) );
+		log << LogBuffer::Severity::INFO
+		    << "Resolved " << path << " to " << resolvedPath << std::flush;
+		return resolvedPath;
+	};
+
+	// Both collections are indexed like the paths in the configuration, but
+	// only those sensors and actuators are opened which are actually used by
+	// a controller.
+	// In particular, opening an actuator takes over control of the fan.
+	// The factories ensure that each device file is opened once even if it
+	// appears under several indices.
+	temperatureSensors.resize( sensorPaths.size() );
+	pwmActuators.resize( actuatorPaths.size() );
+	pwmControllers.reserve( controllerConfigs.size() );
+
+	for( RuntimeConfig::ControllerConfigIdx i = 0; i != controllerConfigs.size(); i++ ) {
+		RuntimeConfig::ControllerConfig const& ctrCnf( controllerConfigs[i] );
+		RuntimeConfig::TemperatureSensorIdxSeq const& sensorIndices( ctrCnf.getTemperatureSensorIdxSeq() );
+		RuntimeConfig::PwmActuatorIdx const actuatorIdx( ctrCnf.getPwmActuatorIdx() );
+
+		auto const undefinedSensorIdx = std::find_if( sensorIndices.begin(), sensorIndices.end(),
+			[&sensorPaths]( RuntimeConfig::TemperatureSensorIdx const sensorIdx ) {
+				return sensorIdx >= sensorPaths.size() || sensorPaths[sensorIdx].empty();
+			}
+		);
+		if( undefinedSensorIdx != sensorIndices.end() ) {
+			log << LogBuffer::Severity::ERROR
+			    << "Controller " << i << " refers to undefined "
+			    << RuntimeConfig::TEMPERATURE_SENSOR_PATH_ATTRIBUTE << "." << *undefinedSensorIdx
+			    << "; controller disabled" << std::flush;
+			continue;
+		}
+		if( actuatorIdx >= actuatorPaths.size() || actuatorPaths[actuatorIdx].empty() ) {
+			log << LogBuffer::Severity::ERROR
+			    << "Controller " << i << " refers to undefined "
+			    << RuntimeConfig::PWM_ACTUATOR_PATH_ATTRIBUTE << "." << actuatorIdx
+			    << "; controller disabled" << std::flush;
+			continue;
+		}
 
-	temperatureSensors.push_back( temperatureSensorFactory.getSensor(
-		 config.getTempSensorFilePath()
-	) );
-	pwmActuators.push_back( pwmActuatorFactory.getActuator(
-		config.getPwmActuatorFilePath()
-	) );
-	pwmControllers.push_back(
-		PWMController( temperatureSensors.back(), pwmActuators.back() )
+		// Resolve all references before any device is opened such that an
+		// unresolvable reference does not leave a half-initialized controller
+		std::vector<std::string> resolvedSensorPaths;
+		std::string resolvedActuatorPath;
+		try {
+			for( RuntimeConfig::TemperatureSensorIdx const sensorIdx : sensorIndices )
+				resolvedSensorPaths.push_back( resolve( sensorPaths[sensorIdx] ) );
+			resolvedActuatorPath = resolve( actuatorPaths[actuatorIdx] );
+		} catch( std::runtime_error const& e ) {
+			log << LogBuffer::Severity::ERROR
+			    << "Controller " << i << " cannot resolve its devices ("
+			    << e.what() << "); controller disabled" << std::flush;
+			continue;
+		}
+
+		// Open all devices before any of them is stored such that a device
+		// which cannot be opened disables the controller without leaving
+		// unused devices behind
+		TemperatureInput::SensorSeq inputSensors;
+		PWMActuator::Ptr actuator( pwmActuators[actuatorIdx] );
+		bool const isSharedActuator( actuator != nullptr );
+		try {
+			for( RuntimeConfig::TemperatureSensorIdxSeq::size_type j = 0; j != sensorIndices.size(); j++ ) {
+				RuntimeConfig::TemperatureSensorIdx const sensorIdx( sensorIndices[j] );
+				inputSensors.push_back( temperatureSensors[sensorIdx] ?
+					temperatureSensors[sensorIdx] :
+					temperatureSensorFactory.getSensor( resolvedSensorPaths[j] )
+				);
+			}
+			if( !actuator ) actuator = pwmActuatorFactory.getActuator( resolvedActuatorPath );
+		} catch( std::system_error const& e ) {
+			log << LogBuffer::Severity::ERROR
+			    << "Controller " << i << " cannot open its devices ("
+			    << e.what() << "); controller disabled" << std::flush;
+			continue;
+		}
+		for( RuntimeConfig::TemperatureSensorIdxSeq::size_type j = 0; j != sensorIndices.size(); j++ )
+			temperatureSensors[sensorIndices[j]] = inputSensors[j];
+		pwmActuators[actuatorIdx] = actuator;
+
+		TemperatureInput input( inputSensors.front() );
+		try {
+			input = TemperatureInput(
+				inputSensors,
+				ctrCnf.getTemperatureAggregation(),
+				ctrCnf.getTemperatureSensorWeights(),
+				ctrCnf.getTemperatureSensorLimits()
+			);
+		} catch( std::invalid_argument const& e ) {
+			log << LogBuffer::Severity::ERROR
+			    << "Controller " << i << " cannot aggregate its temperature sensors ("
+			    << e.what() << "); using the maximum" << std::flush;
+			input = TemperatureInput(
+				inputSensors, TemperatureInput::Aggregation::MAX,
+				TemperatureInput::WeightSeq(), TemperatureInput::LimitSeq()
+			);
+		}
+
+		if( isSharedActuator ) {
+			log << LogBuffer::Severity::WARNING
+			    << "Controller " << i << " shares "
+			    << RuntimeConfig::PWM_ACTUATOR_PATH_ATTRIBUTE << "." << actuatorIdx
+			    << " with another controller" << std::flush;
+		}
+		pwmControllers.push_back( PWMController(
+			ctrCnf, i, input, pwmActuators[actuatorIdx], next->batch,
+			config->getMaxControlInterval()
+		) );
+	}
+	return next;
+}
+
+/**
+ * Returns the indices of the running controllers in the configuration.
+ */
+static MetricsExporter::ControllerIdxSeq getControllerIndices( PWMControllers::PWMControllerCollection const& pwmControllers ) {
+	MetricsExporter::ControllerIdxSeq indices;
+	for( PWMController const& controller : pwmControllers )
+		indices.push_back( controller.getIndex() );
+	return indices;
+}
+
+/**
+ * Returns each sensor of a setup once.
+ */
+static TemperatureAcquisition::SensorCollection getSensors( PWMControllers::TemperatureSensorCollection const& temperatureSensors ) {
+	TemperatureAcquisition::SensorCollection sensors;
+	for( TemperatureSensor::Ptr const& sensor : temperatureSensors ) {
+		if( sensor && std::find( sensors.begin(), sensors.end(), sensor ) == sensors.end() )
+			sensors.push_back( sensor );
+	}
+	return sensors;
+}
+
+/**
+ * Replaces the current setup (if any) by the given one.
+ *
+ * The current setup is destroyed first, i.e. the actuators which are not
+ * used by the new setup hand their fans back to the automatic mode and the
+ * sensors which are not used anymore are closed.
+ * Afterwards, the acquisition, the alarm attributes, the telemetry, the
+ * metrics exporter and the watch of the configuration file follow the new
+ * configuration; the telemetry and the metrics exporter are only re-opened
+ * if their settings (or the number of controllers) have changed.
+ */
+void PWMControllers::activate( std::unique_ptr<Setup> next ) {
+	LogStream& log( LogStream::get() );
+	RuntimeConfig::Ptr const previous( setup ? setup->config : RuntimeConfig::Ptr() );
+	MetricsExporter::ControllerIdxSeq const previousControllerIndices(
+		setup ? getControllerIndices( setup->pwmControllers ) : MetricsExporter::ControllerIdxSeq()
 	);
+
+	// An override survives a new snapshot if the controller keeps its
+	// actuator
+	if( setup ) {
+		PWMControllerCollection& nextControllers( next->pwmControllers );
+		PWMControllerCollection::size_type const count( std::min( setup->pwmControllers.size(), nextControllers.size() ) );
+		for( PWMControllerCollection::size_type i = 0; i != count; i++ ) {
+			PWMController const& controller( setup->pwmControllers[i] );
+			if( controller.isOverridden() && &controller.getActuator() == &nextControllers[i].getActuator() )
+				nextControllers[i].setOverride( controller.getOverridePwmValue(), controller.getOverrideEnd() );
+		}
+	}
+
+	// The alarm attributes must leave the wait set before their sensors may
+	// be closed
+	if( setup ) {
+		for( auto const& sensor : getSensors( setup->temperatureSensors ) ) {
+			for( int const alarmFd : sensor->getAlarmFds() )
+				scheduler.removeFd( alarmFd );
+		}
+	}
+	setup = std::move( next );
+	RuntimeConfig const& config( *setup->config );
+	// The log settings follow a snapshot only once it has been accepted,
+	// i.e. a rejected reload neither changes them nor is logged as if it
+	// were in effect
+	log.setTreshold( config.getLogTreshold() );
+	log.setAsynchronous( config.isLogAsynchronous() );
+	config.logConfiguration();
+	TemperatureAcquisition::SensorCollection const sensors( getSensors( setup->temperatureSensors ) );
+	acquisition.setSensors( sensors, config.getTemperatureAcquisition() );
+
+	if( config.isTemperatureAlarmWakeup() ) {
+		TemperatureSensor::AlarmFdCollection::size_type alarmCount = 0;
+		for( auto const& sensor : sensors ) {
+			sensor->openAlarms();
+			for( int const alarmFd : sensor->getAlarmFds() ) {
+				if( scheduler.addAlarmFd( alarmFd ) ) alarmCount++;
+			}
+		}
+		log << LogBuffer::Severity::INFO
+		    << "Waking up on " << alarmCount << " temperature alarm attribute(s)" << std::flush;
+	}
+
+	if(
+		!previous ||
+		config.getTelemetryFilePath() != previous->getTelemetryFilePath() ||
+		config.getTelemetryRecordCount() != previous->getTelemetryRecordCount()
+	) {
+		telemetry.close();
+		if( !config.getTelemetryFilePath().empty() ) {
+			try {
+				telemetry.open( config.getTelemetryFilePath(), config.getTelemetryRecordCount() );
+				log << LogBuffer::Severity::INFO
+				    << "Recording telemetry to " << config.getTelemetryFilePath() << std::flush;
+			} catch( std::exception const& e ) {
+				log << LogBuffer::Severity::ERROR
+				    << "Cannot record telemetry (" << e.what() << ")" << std::flush;
+			}
+		}
+	}
+
+	if(
+		!previous ||
+		config.getMetricsSocketPath() != previous->getMetricsSocketPath() ||
+		getControllerIndices( setup->pwmControllers ) != previousControllerIndices
+	) {
+		metrics.close();
+		if( !config.getMetricsSocketPath().empty() ) {
+			try {
+				metrics.open( config.getMetricsSocketPath(), getControllerIndices( setup->pwmControllers ) );
+				log << LogBuffer::Severity::INFO
+				    << "Exporting metrics on " << config.getMetricsSocketPath() << std::flush;
+			} catch( std::exception const& e ) {
+				log << LogBuffer::Severity::ERROR
+				    << "Cannot export metrics (" << e.what() << ")" << std::flush;
+			}
+		}
+	}
+
+	if( !previous || config.getAdminSocketPath() != previous->getAdminSocketPath() ) {
+		if( admin.isOpen() ) {
+			scheduler.removeFd( admin.getFd() );
+			admin.close();
+		}
+		if( !config.getAdminSocketPath().empty() ) {
+			try {
+				admin.open( config.getAdminSocketPath() );
+				scheduler.addEventFd( admin.getFd() );
+				log << LogBuffer::Severity::INFO
+				    << "Serving administration requests on " << config.getAdminSocketPath() << std::flush;
+			} catch( std::exception const& e ) {
+				log << LogBuffer::Severity::ERROR
+				    << "Cannot serve administration requests (" << e.what() << ")" << std::flush;
+			}
+		}
+	}
+
+	std::string const watchPath( config.isConfigFileWatch() ? config.getFilePath() : std::string() );
+	if( watchPath != configWatcher.getFilePath() ) {
+		if( configWatcher.isOpen() ) {
+			scheduler.removeFd( configWatcher.getFd() );
+			configWatcher.close();
+		}
+		if( !watchPath.empty() ) {
+			try {
+				configWatcher.watch( watchPath );
+				scheduler.addEventFd( configWatcher.getFd() );
+				log << LogBuffer::Severity::INFO
+				    << "Watching " << watchPath << " for changes" << std::flush;
+			} catch( std::system_error const& e ) {
+				log << LogBuffer::Severity::ERROR
+				    << "Cannot watch configuration file (" << e.what() << ")" << std::flush;
+			}
+		}
+	}
+
+	// The real-time mode is entered last, such that the memory which has
+	// been allocated above is locked, too
+	if( !previous || config.getCpuAffinity() != previous->getCpuAffinity() ) {
+		try {
+			realtime.setCpuAffinity( config.getCpuAffinity() );
+			if( !config.getCpuAffinity().empty() ) {
+				log << LogBuffer::Severity::INFO << "Pinned control thread to CPU(s)";
+				for( unsigned long const cpu : config.getCpuAffinity() ) log << " " << cpu;
+				std::flush( log );
+			}
+		} catch( std::exception const& e ) {
+			log << LogBuffer::Severity::ERROR
+			    << "Cannot pin control thread (" << e.what() << ")" << std::flush;
+		}
+	}
+	if( config.getRealtimePriority() != realtime.getPriority() ) {
+		try {
+			realtime.setPriority( config.getRealtimePriority() );
+			if( realtime.getPriority() != 0 ) {
+				log << LogBuffer::Severity::NOTICE
+				    << "Running control thread with SCHED_FIFO priority " << realtime.getPriority()
+				    << " and locked memory" << std::flush;
+			} else {
+				log << LogBuffer::Severity::NOTICE << "Left real-time mode" << std::flush;
+			}
+		} catch( std::exception const& e ) {
+			log << LogBuffer::Severity::ERROR
+			    << "Cannot enter real-time mode (" << e.what() << ")" << std::flush;
+		}
+	}
+
+	if( runState == RunState::RUNNING )
+		scheduler.setPeriod( config.getControlInterval() );
+}
+
+/**
+ * Dispatches all pending signals.
+ *
+ * Like `stop`, `requestStatistics` and `requestReload`, this only records
+ * what has been requested; the loop acts on it before the next cycle.
+ */
+void PWMControllers::receiveSignals() {
+	LogStream& log( LogStream::get() );
+	for( int signal; ( signal = signals.receive() ) != 0; ) {
+		switch( signal ) {
+			case SIGHUP:
+				isReloadRequested.store( true, std::memory_order_relaxed );
+				break;
+			case SIGUSR1:
+				isStatisticsRequested.store( true, std::memory_order_relaxed );
+				break;
+			default:
+				log << LogBuffer::Severity::NOTICE
+				    << "Received " << strsignal( signal ) << "; stopping" << std::flush;
+				runState.store( RunState::STOPPED, std::memory_order_relaxed );
+				break;
+		}
+	}
+}
+
+/**
+ * Reads a decimal number of an administration request.
+ *
+ * @throw std::invalid_argument if the next token is not a number
+ */
+static unsigned long readNumber( std::istream& request, char const* const name ) {
+	std::string token;
+	request >> token;
+	std::size_t length = 0;
+	unsigned long value = 0;
+	if( !token.empty() && token[0] >= '0' && token[0] <= '9' ) {
+		try {
+			value = std::stoul( token, &length );
+		} catch( std::out_of_range const& ) {
+			length = 0;
+		}
+	}
+	if( token.empty() || length != token.size() )
+		throw std::invalid_argument( std::string( "expected " ) + name );
+	return value;
+}
+
+/**
+ * Returns the running controller with the given index of the
+ * configuration.
+ *
+ * @throw std::invalid_argument if no such controller is running, e.g.
+ * because it is disabled
+ */
+PWMController& PWMControllers::findController( unsigned long const idx ) {
+	for( PWMController& controller : setup->pwmControllers ) {
+		if( controller.getIndex() == idx ) return controller;
+	}
+	throw std::invalid_argument( "no such controller" );
+}
+
+/**
+ * Answers the pending requests of the administration interface.
+ *
+ * @return `true` if a request needs the next cycle to run immediately
+ * (i.e. an override has been changed)
+ */
+bool PWMControllers::serveAdmin() {
+	bool isCycleRequested = false;
+	adminRequests.clear();
+	admin.serve( adminRequests );
+	for( AdminServer::Request const& request : adminRequests )
+		admin.respond( request, handleAdminRequest( request.line, isCycleRequested ) );
+	return isCycleRequested;
+}
+
+/**
+ * Executes a single request of the administration interface, see the
+ * description of the class.
+ *
+ * @return the response including the final status line
+ */
+std::string PWMControllers::handleAdminRequest( std::string const& line, bool& isCycleRequested ) {
+	LogStream& log( LogStream::get() );
+	PWMControllerCollection& pwmControllers( setup->pwmControllers );
+	std::istringstream request( line );
+	request.imbue( std::locale::classic() );
+	std::ostringstream response;
+	response.imbue( std::locale::classic() );
+	std::string command;
+	request >> command;
+
+	try {
+		if( command == "STATUS" ) {
+			PWMController::Clock::time_point const now = PWMController::Clock::now();
+			for( PWMControllerCollection::size_type i = 0; i != pwmControllers.size(); i++ ) {
+				PWMController const& controller( pwmControllers[i] );
+				PWMController::Cycle const& cycle( controller.getLastCycle() );
+				bool const isPid = controller.getConfig().getControlMode() == RuntimeConfig::ControllerConfig::ControlMode::PID;
+				response << "controller=" << controller.getIndex()
+				         << " actuator=" << controller.getActuator().getFilePath()
+				         << " mode=" << ( isPid ? "PID" : "CURVE" )
+				         << " temperature=" << cycle.temperature
+				         << " sensor=" << ( cycle.isSensorOk ? "OK" : "FAILED" )
+				         << " pwm=" << cycle.pwmValue
+				         << " override=";
+				if( controller.isOverridden() ) {
+					Duration const remaining( std::chrono::duration_cast<Duration>( controller.getOverrideEnd() - now ) );
+					response << controller.getOverridePwmValue() << "/" << std::max( remaining.count(), Duration::rep( 0 ) ) << "ms";
+				} else {
+					response << "-";
+				}
+				response << "\n";
+			}
+		} else if( command == "OVERRIDE" ) {
+			unsigned long const idx = readNumber( request, "controller" );
+			unsigned long const pwmValue = readNumber( request, "PWM value" );
+			unsigned long const seconds = readNumber( request, "duration in seconds" );
+			Duration const maxDuration( setup->config->getMaxPwmOverrideDuration() );
+			PWMController& controller( findController( idx ) );
+			if( pwmValue > PWMActuator::MAX_PWM_VALUE )
+				throw std::invalid_argument( "PWM value exceeds " + std::to_string( PWMActuator::MAX_PWM_VALUE ) );
+			if( seconds == 0 || static_cast<unsigned long long>( seconds ) * 1000 > static_cast<unsigned long long>( maxDuration.count() ) )
+				throw std::invalid_argument( "duration must be between 1 s and " + std::to_string( maxDuration.count() / 1000 ) + " s" );
+			controller.setOverride(
+				static_cast<PwmValue>( pwmValue ),
+				PWMController::Clock::now() + Duration( seconds * 1000 )
+			);
+			isCycleRequested = true;
+			log << LogBuffer::Severity::NOTICE
+			    << "PWM of " << controller.getActuator().getFilePath()
+			    << " overridden to " << pwmValue << " for " << seconds << " s" << std::flush;
+		} else if( command == "RELEASE" ) {
+			PWMController& controller( findController( readNumber( request, "controller" ) ) );
+			if( controller.isOverridden() ) {
+				controller.clearOverride();
+				isCycleRequested = true;
+				log << LogBuffer::Severity::NOTICE
+				    << "PWM override of " << controller.getActuator().getFilePath() << " released" << std::flush;
+			}
+		} else if( command == "CURVE" ) {
+			unsigned long const idx = readNumber( request, "controller" );
+			findController( idx );
+			std::string points;
+			std::getline( request >> std::ws, points );
+			// The snapshot is applied right away (this is a cycle boundary),
+			// such that the response tells whether it has been accepted
+			RuntimeConfig::Ptr const config( setup->config->withControlCurve( idx, points ) );
+			RuntimeConfig::publish( config );
+			updateSetup();
+			if( setup->config != config )
+				throw std::invalid_argument( "fan curve rejected" );
+			log << LogBuffer::Severity::NOTICE
+			    << "Fan curve of controller " << idx << " switched to " << points << std::flush;
+		} else if( command == "DUMP" ) {
+			request >> std::ws;
+			unsigned long count = request.eof() ?
+				std::min( 16 * pwmControllers.size(), MAX_DUMP_RECORDS ) :
+				readNumber( request, "record count" );
+			if( !telemetry.isOpen() )
+				throw std::invalid_argument( "telemetry is disabled" );
+			std::uint64_t const end = telemetry.getWriteIndex();
+			count = std::min( { count, static_cast<unsigned long>( MAX_DUMP_RECORDS ), static_cast<unsigned long>( std::min( end, telemetry.getCapacity() ) ) } );
+			response << "sequence,timestamp_ns,controller,temperature_mC,sensor_ok,needs_update,calculated_pwm,written_pwm,read_latency_ns,write_latency_ns\n";
+			for( std::uint64_t i = end - count; i != end; i++ ) {
+				TelemetryRing::Record const& r( telemetry.getRecord( i ) );
+				response << r.sequence << ',' << r.timestamp << ',' << r.controllerIdx << ','
+				         << r.temperature << ',' << unsigned( r.isSensorOk ) << ',' << unsigned( r.isUpdateNeeded ) << ','
+				         << r.calculatedPwmValue << ',' << r.pwmValue << ','
+				         << r.readLatency << ',' << r.writeLatency << '\n';
+			}
+		} else if( command == "HELP" ) {
+			response << "STATUS\n"
+			         << "OVERRIDE <controller> <pwm> <seconds>\n"
+			         << "RELEASE <controller>\n"
+			         << "CURVE <controller> <temperature>:<pwm> ...\n"
+			         << "DUMP [<count>]\n"
+			         << "HELP\n";
+		} else {
+			throw std::invalid_argument( command.empty() ? "empty request" : "unknown command " + command );
+		}
+	} catch( std::exception const& e ) {
+		return std::string( "ERROR " ) + e.what() + "\n";
+	}
+	response << "OK\n";
+	return response.str();
+}
+
+/**
+ * Loads the configuration file of the current snapshot anew and publishes
+ * the result, see `updateSetup`.
+ */
+void PWMControllers::reload() {
+	LogStream& log( LogStream::get() );
+	std::string const& filePath( setup->config->getFilePath() );
+	log << LogBuffer::Severity::NOTICE << "Reloading configuration" << std::flush;
+	try {
+		RuntimeConfig::publish( filePath.empty() ? RuntimeConfig::load() : RuntimeConfig::load( filePath ) );
+	} catch( std::runtime_error const& e ) {
+		log << LogBuffer::Severity::ERROR
+		    << "Cannot reload configuration (" << e.what() << ")" << std::flush;
+	}
+}
+
+/**
+ * Switches to the most recently published configuration snapshot if it
+ * differs from the current one.
+ *
+ * Must only be called at a cycle boundary.
+ * If the new snapshot does not yield any working controller or building
+ * the controllers fails, the current controllers keep running and the
+ * current snapshot is published again.
+ */
+void PWMControllers::updateSetup() {
+	RuntimeConfig::Ptr const config( RuntimeConfig::getCurrent() );
+	if( config == setup->config ) return;
+
+	LogStream& log( LogStream::get() );
+	std::unique_ptr<Setup> next;
+	try {
+		next = createSetup( config );
+	} catch( std::exception const& e ) {
+		log << LogBuffer::Severity::ERROR
+		    << "Cannot apply configuration (" << e.what() << "); keeping the previous configuration" << std::flush;
+		RuntimeConfig::publish( setup->config );
+		return;
+	}
+	if( next->pwmControllers.empty() ) {
+		log << LogBuffer::Severity::ERROR
+		    << "No controller configured; keeping the previous configuration" << std::flush;
+		RuntimeConfig::publish( setup->config );
+		return;
+	}
+	// Once the new setup has replaced the current one, a failure only
+	// affects an auxiliary facility (e.g. the wait set); the controllers
+	// of the new setup are in place and keep running
+	try {
+		activate( std::move( next ) );
+	} catch( std::exception const& e ) {
+		log << LogBuffer::Severity::ERROR
+		    << "Configuration applied incompletely (" << e.what() << ")" << std::flush;
+		RuntimeConfig::publish( setup->config );
+		return;
+	}
+	log << LogBuffer::Severity::NOTICE
+	    << "Configuration applied to " << setup->pwmControllers.size() << " controller(s)" << std::flush;
 }
 
 PWMControllers& PWMControllers::get() {
@@ -38,6 +626,11 @@ PWMControllers& PWMControllers::get() {
 
 int PWMControllers::run() {
 	if( runState == RunState::RUNNING ) return 0;
+	if( setup->pwmControllers.empty() ) {
+		LogStream& log( LogStream::get() );
+		log << LogBuffer::Severity::ERROR << "No controller configured" << std::flush;
+		return 1;
+	}
 	runState = RunState::RUNNING;
 	return loop();
 }
@@ -47,11 +640,193 @@ int PWMControllers::loop() {
 	log << LogBuffer::Severity::INFO;
 
 	log << "Entering control loop" << std::flush;
+	scheduler.start( setup->config->getControlInterval() );
 	while( runState == RunState::RUNNING ) {
-		for ( auto& controller : pwmControllers ) controller.update();
-		std::this_thread::sleep_for( config.getControlInterval() );
+		DeadlineScheduler::Clock::time_point const cycleStart = DeadlineScheduler::Clock::now();
+		acquisition.acquire();
+		DeadlineScheduler::Clock::time_point const calcStart = DeadlineScheduler::Clock::now();
+		acquisitionHistogram.record( calcStart - cycleStart );
+		// The math of all controllers is evaluated at once, only the
+		// remainder of the cycle (writes, logging) runs per controller
+		PWMControllerCollection& pwmControllers( setup->pwmControllers );
+		for( auto& controller : pwmControllers ) controller.prepare();
+		setup->batch.evaluate();
+		Latency const calcLatency( DeadlineScheduler::Clock::now() - calcStart );
+		bool isStable = true;
+		for( PWMControllerCollection::size_type i = 0; i != pwmControllers.size(); i++ ) {
+			DeadlineScheduler::Clock::time_point const updateStart = DeadlineScheduler::Clock::now();
+			if( pwmControllers[i].apply( calcLatency ) ) isStable = false;
+			if( metrics.isOpen() ) {
+				Latency const updateLatency( DeadlineScheduler::Clock::now() - updateStart );
+				MetricsExporter::publish( metrics.getControllerMetrics( i ).updateLatency, updateLatency.count() );
+			}
+		}
+		if( telemetry.isOpen() ) recordTelemetry( cycleStart );
+		if( setup->config->isAdaptiveControlInterval() ) adaptControlInterval( isStable );
+		Latency const cycleLatency( DeadlineScheduler::Clock::now() - cycleStart );
+		cycleHistogram.record( cycleLatency );
+		if( metrics.isOpen() ) publishMetrics( cycleLatency );
+		// Wait for the next tick; the wait returns early if a signal has been
+		// received, the configuration file has changed or another thread has
+		// made a request and then the run state is re-evaluated, the
+		// statistics are logged and the configuration is reloaded if
+		// requested, or if a temperature alarm has changed or an
+		// administration request has changed an override and then the next
+		// cycle runs immediately.
+		// In any case, a newly published configuration is applied before the
+		// next cycle.
+		DeadlineScheduler::Wakeup wakeup;
+		bool isCycleRequested = false;
+		do {
+			wakeup = scheduler.wait();
+			if( scheduler.isReady( signals.getFd() ) )
+				receiveSignals();
+			if( admin.isOpen() && scheduler.isReady( admin.getFd() ) && serveAdmin() )
+				isCycleRequested = true;
+			if( isStatisticsRequested.exchange( false, std::memory_order_relaxed ) )
+				logStatistics();
+			if( configWatcher.isOpen() && scheduler.isReady( configWatcher.getFd() ) && configWatcher.consume() ) {
+				log << LogBuffer::Severity::NOTICE
+				    << "Configuration file " << configWatcher.getFilePath() << " has changed" << std::flush;
+				isReloadRequested.store( true, std::memory_order_relaxed );
+			}
+			if( isReloadRequested.exchange( false, std::memory_order_relaxed ) )
+				reload();
+			updateSetup();
+		} while(
+			( wakeup == DeadlineScheduler::Wakeup::INTERRUPTED || wakeup == DeadlineScheduler::Wakeup::EVENT ) &&
+			runState == RunState::RUNNING && !isCycleRequested
+		);
+		if( wakeup == DeadlineScheduler::Wakeup::ALARM ) {
+			log << LogBuffer::Severity::NOTICE
+			    << "Woken up by temperature alarm" << std::flush;
+		}
 	}
-	log << "Exiting control loop" << std::flush;
+	log << LogBuffer::Severity::INFO << "Exiting control loop" << std::flush;
+	logStatistics();
 	return 0;
 }
+
+/**
+ * Adapts the control interval to the thermal situation.
+ *
+ * While all temperatures stay within the hysteresis band of their
+ * controller, the interval is doubled for each cycle up to the maximum
+ * control interval.
+ * As soon as any temperature leaves the band, the interval snaps back to
+ * the (minimum) control interval.
+ */
+void PWMControllers::adaptControlInterval( bool const isStable ) {
+	Duration const interval( isStable ?
+		std::min( 2 * scheduler.getPeriod(), setup->config->getMaxControlInterval() ) :
+		setup->config->getControlInterval()
+	);
+	if( interval == scheduler.getPeriod() ) return;
+
+	scheduler.setPeriod( interval );
+	LogStream& log(LogStream::get());
+	AMDGPU_FANCTRL_LOG( log, LogBuffer::Severity::DEBUG )
+		<< "Control interval adapted to " << interval.count() << " ms" << std::flush;
+}
+
+void PWMControllers::recordTelemetry( DeadlineScheduler::Clock::time_point const timestamp ) {
+	PWMControllerCollection const& pwmControllers( setup->pwmControllers );
+	std::uint64_t const ns = std::chrono::duration_cast<Latency>( timestamp.time_since_epoch() ).count();
+	for( PWMControllerCollection::size_type i = 0; i != pwmControllers.size(); i++ ) {
+		PWMController::Cycle const& cycle( pwmControllers[i].getLastCycle() );
+		TelemetryRing::Record& r( telemetry.next() );
+		r.timestamp = ns;
+		r.controllerIdx = pwmControllers[i].getIndex();
+		r.temperature = cycle.temperature;
+		r.calculatedPwmValue = cycle.calculatedPwmValue;
+		r.pwmValue = cycle.pwmValue;
+		r.readLatency = TelemetryRing::toRecordLatency( cycle.readLatency );
+		r.writeLatency = TelemetryRing::toRecordLatency( cycle.writeLatency );
+		r.isUpdateNeeded = cycle.isUpdateNeeded;
+		r.isSensorOk = cycle.isSensorOk;
+		telemetry.commit();
+	}
+}
+
+/**
+ * Publishes the state after a cycle to the metrics exporter.
+ *
+ * Only stores into relaxed atomics, i.e. never waits for the exporter.
+ */
+void PWMControllers::publishMetrics( Latency const cycleLatency ) {
+	PWMControllerCollection const& pwmControllers( setup->pwmControllers );
+	for( PWMControllerCollection::size_type i = 0; i != pwmControllers.size(); i++ ) {
+		PWMController const& controller( pwmControllers[i] );
+		PWMController::Cycle const& cycle( controller.getLastCycle() );
+		MetricsExporter::ControllerMetrics& m( metrics.getControllerMetrics( i ) );
+		MetricsExporter::publish( m.temperature, cycle.temperature );
+		MetricsExporter::publish( m.pwmValue, cycle.pwmValue );
+		MetricsExporter::publish( m.writesIssued, controller.getActuator().getWritesIssued() );
+		MetricsExporter::publish( m.writesElided, controller.getActuator().getWritesElided() );
+		MetricsExporter::publish( m.skippedUpdates, controller.getSkippedUpdates() );
+		MetricsExporter::publish( m.sensorErrors, controller.getSensorErrors() );
+		MetricsExporter::publish( m.writeErrors, controller.getWriteErrors() );
+		MetricsExporter::publish( m.readLatency, cycle.readLatency.count() );
+	}
+	MetricsExporter::LoopMetrics& m( metrics.getLoopMetrics() );
+	MetricsExporter::publish( m.cycles, cycleHistogram.getCount() );
+	MetricsExporter::publish( m.cycleLatency, cycleLatency.count() );
+	MetricsExporter::publish( m.cycleLatencySum,
+		m.cycleLatencySum.load( std::memory_order_relaxed ) + cycleLatency.count()
+	);
+	MetricsExporter::publish( m.ticks, scheduler.getTicks() );
+	MetricsExporter::publish( m.overruns, scheduler.getOverruns() );
+	MetricsExporter::publish( m.skippedTicks, scheduler.getSkippedTicks() );
+	MetricsExporter::publish( m.alarmWakeups, scheduler.getAlarmWakeups() );
+	MetricsExporter::publish( m.maxWakeupLatency, scheduler.getMaxLatency().count() );
+}
+
+void PWMControllers::logStatistics() const {
+	LogStream& log(LogStream::get());
+	log << LogBuffer::Severity::INFO;
+
+	log << "Scheduler: " << scheduler.getTicks() << " tick(s), "
+	    << scheduler.getOverruns() << " overrun(s), "
+	    << scheduler.getSkippedTicks() << " skipped tick(s), "
+	    << scheduler.getAlarmWakeups() << " alarm wakeup(s), period jitter mean "
+	    << std::chrono::duration_cast<std::chrono::microseconds>( scheduler.getMeanJitter() ).count()
+	    << " µs / max "
+	    << std::chrono::duration_cast<std::chrono::microseconds>( scheduler.getMaxJitter() ).count()
+	    << " µs, max wakeup latency "
+	    << std::chrono::duration_cast<std::chrono::microseconds>( scheduler.getMaxLatency() ).count()
+	    << " µs, " << scheduler.getWakeupRate() << " wakeup(s)/s" << std::flush;
+	for( auto const& actuator : setup->pwmActuators ) {
+		if( !actuator ) continue;
+		log << actuator->getFilePath() << ": "
+		    << actuator->getWritesIssued() << " write(s) issued, "
+		    << actuator->getWritesElided() << " write(s) elided" << std::flush;
+	}
+	logHistogram( "Wakeup", scheduler.getLatencyHistogram() );
+	logHistogram( "Acquisition", acquisitionHistogram );
+	logHistogram( "Cycle", cycleHistogram );
+	PWMControllerCollection const& pwmControllers( setup->pwmControllers );
+	for( PWMControllerCollection::size_type i = 0; i != pwmControllers.size(); i++ ) {
+		for( unsigned short s = 0; s != PWMController::Stage::STAGE_COUNT; s++ ) {
+			PWMController::Stage const stage = static_cast<PWMController::Stage>( s );
+			std::string const name( "Controller " + std::to_string( i ) + " " + PWMController::STAGE_NAMES[stage] );
+			logHistogram( name.c_str(), pwmControllers[i].getHistogram( stage ) );
+		}
+	}
+}
+
+/**
+ * Logs the percentiles of a latency histogram.
+ *
+ * Histograms without any samples (e.g. the write stage of a controller
+ * which has never needed an update) are skipped.
+ */
+void PWMControllers::logHistogram( char const* name, LatencyHistogram const& histogram ) {
+	if( histogram.getCount() == 0 ) return;
+	LogStream& log(LogStream::get());
+	log << LogBuffer::Severity::INFO
+	    << name << " latency: " << histogram.getCount() << " sample(s), p50 "
+	    << histogram.getPercentile( 50.0 ).count() << " ns / p99 "
+	    << histogram.getPercentile( 99.0 ).count() << " ns / max "
+	    << histogram.getMax().count() << " ns" << std::flush;
+}
 }
@@ -3,9 +3,66 @@
 
 #include "runtime_config.h"
 #include "pwm_controller.h"
+#include "controller_batch.h"
+#include "temp_acquisition.h"
+#include "scheduler.h"
+#include "telemetry.h"
+#include "histogram.h"
+#include "metrics_exporter.h"
+#include "config_watcher.h"
+#include "signal_receiver.h"
+#include "admin_server.h"
+#include "realtime.h"
+#include <string>
+#include <atomic>
+#include <memory>
 #include <vector>
 
 namespace AmdGpuFanControl {
+/**
+ * Runs the control loop for all controllers.
+ *
+ * The controllers are built from the published configuration snapshot,
+ * see `RuntimeConfig::getCurrent`.
+ * Whenever a new snapshot is published (e.g. after `requestReload`), the
+ * loop builds a new set of controllers from it at the next cycle boundary
+ * while the current ones are still in place and then replaces them.
+ * As the factories hand out the same object for the same device file, the
+ * sensors and actuators which are used by both snapshots are neither
+ * closed nor re-opened, i.e. the fans are not handed back to the automatic
+ * mode in between.
+ *
+ * The loop blocks in a single place, the wait set of the scheduler, which
+ * also receives the signals (see `SignalReceiver`) and the changes of the
+ * configuration file.
+ * `SIGHUP` reloads the configuration, `SIGUSR1` logs the statistics and
+ * `SIGINT`, `SIGQUIT`, `SIGTERM` and `SIGTSTP` stop the loop; all of them
+ * take effect immediately rather than at the next tick.
+ * The signals are blocked on the thread which constructs the instance,
+ * i.e. `get` must first be called on the thread which runs the loop.
+ *
+ * If configured, the loop also serves the administration interface (see
+ * `AdminServer`) between two cycles.
+ * Like the telemetry and the metrics, the requests identify a controller
+ * by its index in the configuration, i.e. a disabled controller leaves a
+ * gap; the requests are:
+ *  - `STATUS`: one line per controller with the state of its last cycle
+ *  - `OVERRIDE <controller> <pwm> <seconds>`: pins the PWM value of a
+ *    controller for at most `MAX_PWM_OVERRIDE_DURATION`
+ *  - `RELEASE <controller>`: ends an override early
+ *  - `CURVE <controller> <points>`: switches the fan curve of a controller
+ *    (in the syntax of `CONTROL_CURVE`) by publishing a modified snapshot,
+ *    which is applied before the response; the change lasts until the
+ *    configuration is reloaded
+ *  - `DUMP [<count>]`: the most recent telemetry records as CSV
+ *  - `HELP`
+ *
+ * If `REALTIME_PRIORITY` is set, the thread which constructs the instance
+ * enters the real-time mode (see `RealtimeMode`) once everything the loop
+ * needs has been allocated, i.e. before `loop` is entered.
+ * The statistics report the distribution of the wakeup latency, whose
+ * maximum is the bound achieved in this mode.
+ */
 class PWMControllers {
 	public:
 		enum RunState {
@@ -13,10 +70,28 @@ class PWMControllers {
 			RUNNING
 		};
 
+		static std::size_t const MAX_DUMP_RECORDS;
+
 		typedef std::vector<TemperatureSensor::Ptr> TemperatureSensorCollection;
 		typedef std::vector<PWMActuator::Ptr> PWMActuatorCollection;
 		typedef std::vector<PWMController> PWMControllerCollection;
 
+	private:
+		/**
+		 * Everything which is built from a single snapshot of the
+		 * configuration.
+		 *
+		 * The controllers refer to the snapshot and to the batch; the
+		 * snapshot is declared first such that it is released last.
+		 */
+		struct Setup {
+			RuntimeConfig::Ptr config;
+			TemperatureSensorCollection temperatureSensors;
+			PWMActuatorCollection pwmActuators;
+			ControllerBatch batch;
+			PWMControllerCollection pwmControllers;
+		};
+
 	private:
 		PWMControllers();
 		PWMControllers( PWMControllers const& ) = delete;
@@ -26,17 +101,69 @@ class PWMControllers {
 	public:
 		static PWMControllers& get();
 		int run();
-		inline void stop() { runState = RunState::STOPPED; };
+		/**
+		 * Stops the loop after the current cycle.
+		 *
+		 * The method is thread-safe and async-signal-safe.
+		 */
+		inline void stop() {
+			runState.store( RunState::STOPPED, std::memory_order_relaxed );
+			scheduler.notify();
+		};
+		/**
+		 * Requests the statistics to be logged after the current cycle.
+		 *
+		 * The method is thread-safe and async-signal-safe.
+		 */
+		inline void requestStatistics() {
+			isStatisticsRequested.store( true, std::memory_order_relaxed );
+			scheduler.notify();
+		};
+		/**
+		 * Requests the configuration file to be reloaded after the current
+		 * cycle.
+		 *
+		 * The method is thread-safe and async-signal-safe.
+		 */
+		inline void requestReload() {
+			isReloadRequested.store( true, std::memory_order_relaxed );
+			scheduler.notify();
+		};
 
 	protected:
 		int loop();
+		static std::unique_ptr<Setup> createSetup( RuntimeConfig::Ptr const& config );
+		void activate( std::unique_ptr<Setup> next );
+		void receiveSignals();
+		bool serveAdmin();
+		PWMController& findController( unsigned long const idx );
+		std::string handleAdminRequest( std::string const& line, bool& isCycleRequested );
+		void reload();
+		void updateSetup();
+		void adaptControlInterval( bool const isStable );
+		void recordTelemetry( DeadlineScheduler::Clock::time_point const timestamp );
+		void publishMetrics( Latency const cycleLatency );
+		void logStatistics() const;
+		static void logHistogram( char const* name, LatencyHistogram const& histogram );
 
 	private:
-		RuntimeConfig const& config;
-		RunState runState;
-		TemperatureSensorCollection temperatureSensors;
-		PWMActuatorCollection pwmActuators;
-		PWMControllerCollection pwmControllers;
+		std::atomic<RunState> runState;
+		// Declared before the setup such that the signals stay blocked until
+		// the actuators have handed the fans back to the automatic mode
+		SignalReceiver signals;
+		std::unique_ptr<Setup> setup;
+		TemperatureAcquisition acquisition;
+		DeadlineScheduler scheduler;
+		TelemetryRing telemetry;
+		MetricsExporter metrics;
+		ConfigWatcher configWatcher;
+		AdminServer admin;
+		AdminServer::RequestSeq adminRequests;
+		RealtimeMode realtime;
+		LatencyHistogram acquisitionHistogram;
+		LatencyHistogram cycleHistogram;
+		std::atomic<bool> isStatisticsRequested;
+		std::atomic<bool> isReloadRequested;
 };
 }
 
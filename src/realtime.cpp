@@ -0,0 +1,147 @@
+#include "realtime.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <malloc.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace AmdGpuFanControl {
+
+std::size_t const RealtimeMode::HEAP_RESERVE_SIZE( 8 * 1024 * 1024 );
+
+/**
+ * @internal On Linux, `sched_setscheduler` and `sched_setaffinity` with
+ * pid 0 only affect the calling thread, not the entire process.
+ */
+RealtimeMode::RealtimeMode() :
+	priority( 0 ),
+	isLocked( false ),
+	isPinned( false ),
+	originalCpus() {
+	CPU_ZERO( &originalCpus );
+	if( sched_getaffinity( 0, sizeof( originalCpus ), &originalCpus ) == -1 )
+		throw std::system_error( errno, std::generic_category(), "sched_getaffinity" );
+}
+
+RealtimeMode::~RealtimeMode() {
+	try {
+		setPriority( 0 );
+		setCpuAffinity( CpuSeq() );
+	} catch( std::exception const& ) {
+		// Nothing left to do
+	}
+}
+
+/**
+ * Enters `SCHED_FIFO` with the given priority or returns to `SCHED_OTHER`
+ * if the priority is zero.
+ *
+ * The memory is locked before the policy is changed, such that the thread
+ * never runs with a real-time priority while it may still fault.
+ *
+ * @throw std::system_error if the memory cannot be locked or the policy
+ * cannot be changed
+ */
+void RealtimeMode::setPriority( int const prio ) {
+	if( prio == priority ) return;
+	if( prio != 0 ) {
+		lockMemory();
+		sched_param const param = { prio };
+		if( sched_setscheduler( 0, SCHED_FIFO, &param ) == -1 ) {
+			int const e = errno;
+			if( priority == 0 ) unlockMemory();
+			throw std::system_error( e, std::generic_category(), "sched_setscheduler" );
+		}
+	} else {
+		sched_param const param = { 0 };
+		if( sched_setscheduler( 0, SCHED_OTHER, &param ) == -1 )
+			throw std::system_error( errno, std::generic_category(), "sched_setscheduler" );
+		unlockMemory();
+	}
+	priority = prio;
+}
+
+/**
+ * Pins the thread to the given CPUs or restores the affinity the thread
+ * had initially if the sequence is empty.
+ *
+ * @throw std::invalid_argument if a CPU number is out of range
+ * @throw std::system_error if the affinity cannot be changed, e.g. because
+ * none of the CPUs is online
+ */
+void RealtimeMode::setCpuAffinity( CpuSeq const& cpus ) {
+	if( cpus.empty() && !isPinned ) return;
+	cpu_set_t set;
+	if( cpus.empty() ) {
+		set = originalCpus;
+	} else {
+		CPU_ZERO( &set );
+		for( unsigned long const cpu : cpus ) {
+			if( cpu >= CPU_SETSIZE )
+				throw std::invalid_argument( "CPU " + std::to_string( cpu ) + " out of range" );
+			CPU_SET( cpu, &set );
+		}
+	}
+	if( sched_setaffinity( 0, sizeof( set ), &set ) == -1 )
+		throw std::system_error( errno, std::generic_category(), "sched_setaffinity" );
+	isPinned = !cpus.empty();
+}
+
+/**
+ * Locks all current and future memory of the process.
+ *
+ * The heap is neither trimmed nor extended by separate mappings anymore,
+ * i.e. memory which has once been faulted in stays resident and is
+ * re-used by later allocations.
+ */
+void RealtimeMode::lockMemory() {
+	if( isLocked ) return;
+	if( mlockall( MCL_CURRENT | MCL_FUTURE ) == -1 )
+		throw std::system_error( errno, std::generic_category(), "mlockall" );
+	mallopt( M_TRIM_THRESHOLD, -1 );
+	mallopt( M_MMAP_MAX, 0 );
+	prefaultStack();
+	prefaultHeap();
+	isLocked = true;
+}
+
+/**
+ * Unlocks the memory; the allocator keeps its settings, which only cost
+ * some memory which is never returned to the system.
+ */
+void RealtimeMode::unlockMemory() {
+	if( !isLocked ) return;
+	munlockall();
+	isLocked = false;
+}
+
+/**
+ * Touches each page of the stack up to `STACK_RESERVE_SIZE` below the
+ * current frame.
+ */
+void RealtimeMode::prefaultStack() {
+	unsigned char stack[STACK_RESERVE_SIZE];
+	long const pageSize = sysconf( _SC_PAGESIZE );
+	for( std::size_t i = 0; i < STACK_RESERVE_SIZE; i += pageSize )
+		reinterpret_cast<unsigned char volatile*>( stack )[i] = 0;
+}
+
+/**
+ * Extends the heap by `HEAP_RESERVE_SIZE` and releases it again.
+ *
+ * As trimming is disabled, the released memory stays with the allocator.
+ */
+void RealtimeMode::prefaultHeap() {
+	unsigned char* const reserve = static_cast<unsigned char*>( std::malloc( HEAP_RESERVE_SIZE ) );
+	if( reserve == nullptr ) return;
+	long const pageSize = sysconf( _SC_PAGESIZE );
+	for( std::size_t i = 0; i < HEAP_RESERVE_SIZE; i += pageSize )
+		reinterpret_cast<unsigned char volatile*>( reserve )[i] = 0;
+	std::free( reserve );
+}
+
+}
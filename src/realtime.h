@@ -0,0 +1,68 @@
+#ifndef _REALTIME_H_
+#define _REALTIME_H_
+
+#include <cstddef>
+#include <vector>
+#include <sched.h>
+
+namespace AmdGpuFanControl {
+
+/**
+ * Runs the calling (control) thread with a bounded wakeup latency.
+ *
+ * If enabled, the thread
+ *  - is scheduled as `SCHED_FIFO`, i.e. it preempts every ordinary task as
+ *    soon as its timer expires,
+ *  - is optionally pinned to a set of (housekeeping) CPUs, and
+ *  - never waits for a page fault, as all memory of the process is locked
+ *    with `mlockall` and the stack and a reserve of the heap are faulted in
+ *    up front.
+ * As the heap is never trimmed nor served by fresh mappings afterwards,
+ * allocations of the control cycle are satisfied by already resident
+ * memory.
+ *
+ * Threads which are started afterwards inherit the policy and the
+ * affinity; background threads drop back to `SCHED_OTHER` themselves, see
+ * `LogRing` and `MetricsExporter`.
+ *
+ * Unlike most other settings, the mode cannot be entered without
+ * privileges (`CAP_SYS_NICE` and `CAP_IPC_LOCK` or sufficient
+ * `RLIMIT_RTPRIO` and `RLIMIT_MEMLOCK`).
+ * All methods throw `std::system_error` in that case and the thread keeps
+ * its previous state as far as possible.
+ */
+class RealtimeMode {
+	public:
+		typedef std::vector<unsigned long> CpuSeq;
+
+		static constexpr std::size_t STACK_RESERVE_SIZE = 256 * 1024;
+		static std::size_t const HEAP_RESERVE_SIZE;
+
+	public:
+		RealtimeMode();
+		RealtimeMode( RealtimeMode const& ) = delete;
+		RealtimeMode& operator=( RealtimeMode const& ) = delete;
+		~RealtimeMode();
+
+	public:
+		void setPriority( int const prio );
+		void setCpuAffinity( CpuSeq const& cpus );
+		int getPriority() const { return priority; };
+		bool isMemoryLocked() const { return isLocked; };
+
+	private:
+		void lockMemory();
+		void unlockMemory();
+		static void prefaultStack();
+		static void prefaultHeap();
+
+	private:
+		int priority;
+		bool isLocked;
+		bool isPinned;
+		cpu_set_t originalCpus;
+};
+
+}
+
+#endif
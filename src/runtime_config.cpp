@@ -1,117 +1,492 @@
 #include "runtime_config.h"
 
-#include <sstream>
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <limits>
 #include <string>
+#include <string_view>
 #include <fstream>
-#include <regex>
+#include <stdexcept>
 #include "logger2.h"
+#include "perfect_hash.h"
+#include "pwm_actuator.h"
 
 namespace AmdGpuFanControl {
 
+/**
+ * All attributes; `UNKNOWN` must be the last one and equals the number of
+ * known attributes.
+ */
+enum class RuntimeConfig::Attribute : unsigned char {
+	LOG_TRESHOLD,
+	LOG_ASYNCHRONOUS,
+	CONTROL_INTERVAL,
+	MAX_CONTROL_INTERVAL,
+	TEMPERATURE_ALARM_WAKEUP,
+	TEMPERATURE_ACQUISITION,
+	TELEMETRY_FILE_PATH,
+	TELEMETRY_RECORD_COUNT,
+	METRICS_SOCKET_PATH,
+	HWMON_CACHE_FILE_PATH,
+	CONFIG_FILE_WATCH,
+	ADMIN_SOCKET_PATH,
+	MAX_PWM_OVERRIDE_DURATION,
+	REALTIME_PRIORITY,
+	CPU_AFFINITY,
+	TEMPERATURE_SENSOR_PATH,
+	PWM_ACTUATOR_PATH,
+	TEMPERATURE_SENSOR_INDEX,
+	TEMPERATURE_AGGREGATION,
+	TEMPERATURE_SENSOR_WEIGHTS,
+	TEMPERATURE_SENSOR_LIMITS,
+	PWM_ACTUATOR_INDEX,
+	UPWARD_TEMPERATURE_HYSTERESIS,
+	DOWNWARD_TEMPERATURE_HYSTERESIS,
+	BASE_CONTROL_TEMPERATURE,
+	BASE_CONTROL_PWM,
+	MIN_CONTROL_TEMPERATURE,
+	MIN_CONTROL_PWM,
+	MAX_CONTROL_TEMPERATURE,
+	MAX_CONTROL_PWM,
+	CONTROL_CURVE,
+	CONTROL_MODE,
+	PID_TARGET_TEMPERATURE,
+	PID_PROPORTIONAL_GAIN,
+	PID_INTEGRAL_GAIN,
+	PID_DERIVATIVE_GAIN,
+	PID_SLEW_RATE,
+	PID_OUTPUT_HYSTERESIS,
+	TEMPERATURE_FILTER,
+	TEMPERATURE_FILTER_WINDOW,
+	TEMPERATURE_FILTER_EMA_SHIFT,
+	UNKNOWN
+};
+
+namespace {
+
+typedef RuntimeConfig::Attribute Attribute;
+
+constexpr std::size_t ATTRIBUTE_COUNT = static_cast<std::size_t>( Attribute::UNKNOWN );
+
+struct AttributeName {
+	Attribute attribute;
+	std::string_view name;
+};
+
+/**
+ * Names of all attributes in the order of `RuntimeConfig::Attribute`.
+ */
+constexpr AttributeName ATTRIBUTE_NAMES[] = {
+	{ Attribute::LOG_TRESHOLD, "LOG_TRESHOLD" },
+	{ Attribute::LOG_ASYNCHRONOUS, "LOG_ASYNCHRONOUS" },
+	{ Attribute::CONTROL_INTERVAL, "CONTROL_INTERVAL" },
+	{ Attribute::MAX_CONTROL_INTERVAL, "MAX_CONTROL_INTERVAL" },
+	{ Attribute::TEMPERATURE_ALARM_WAKEUP, "TEMPERATURE_ALARM_WAKEUP" },
+	{ Attribute::TEMPERATURE_ACQUISITION, "TEMPERATURE_ACQUISITION" },
+	{ Attribute::TELEMETRY_FILE_PATH, "TELEMETRY_FILE_PATH" },
+	{ Attribute::TELEMETRY_RECORD_COUNT, "TELEMETRY_RECORD_COUNT" },
+	{ Attribute::METRICS_SOCKET_PATH, "METRICS_SOCKET_PATH" },
+	{ Attribute::HWMON_CACHE_FILE_PATH, "HWMON_CACHE_FILE_PATH" },
+	{ Attribute::CONFIG_FILE_WATCH, "CONFIG_FILE_WATCH" },
+	{ Attribute::ADMIN_SOCKET_PATH, "ADMIN_SOCKET_PATH" },
+	{ Attribute::MAX_PWM_OVERRIDE_DURATION, "MAX_PWM_OVERRIDE_DURATION" },
+	{ Attribute::REALTIME_PRIORITY, "REALTIME_PRIORITY" },
+	{ Attribute::CPU_AFFINITY, "CPU_AFFINITY" },
+	{ Attribute::TEMPERATURE_SENSOR_PATH, "TEMPERATURE_SENSOR_PATH" },
+	{ Attribute::PWM_ACTUATOR_PATH, "PWM_ACTUATOR_PATH" },
+	{ Attribute::TEMPERATURE_SENSOR_INDEX, "TEMPERATURE_SENSOR_INDEX" },
+	{ Attribute::TEMPERATURE_AGGREGATION, "TEMPERATURE_AGGREGATION" },
+	{ Attribute::TEMPERATURE_SENSOR_WEIGHTS, "TEMPERATURE_SENSOR_WEIGHTS" },
+	{ Attribute::TEMPERATURE_SENSOR_LIMITS, "TEMPERATURE_SENSOR_LIMITS" },
+	{ Attribute::PWM_ACTUATOR_INDEX, "PWM_ACTUATOR_INDEX" },
+	{ Attribute::UPWARD_TEMPERATURE_HYSTERESIS, "UPWARD_TEMPERATURE_HYSTERESIS" },
+	{ Attribute::DOWNWARD_TEMPERATURE_HYSTERESIS, "DOWNWARD_TEMPERATURE_HYSTERESIS" },
+	{ Attribute::BASE_CONTROL_TEMPERATURE, "BASE_CONTROL_TEMPERATURE" },
+	{ Attribute::BASE_CONTROL_PWM, "BASE_CONTROL_PWM" },
+	{ Attribute::MIN_CONTROL_TEMPERATURE, "LOW_CONTROL_TEMPERATURE" },
+	{ Attribute::MIN_CONTROL_PWM, "LOW_CONTROL_PWM" },
+	{ Attribute::MAX_CONTROL_TEMPERATURE, "HIGH_CONTROL_TEMPERATURE" },
+	{ Attribute::MAX_CONTROL_PWM, "HIGH_CONTROL_PWM" },
+	{ Attribute::CONTROL_CURVE, "CONTROL_CURVE" },
+	{ Attribute::CONTROL_MODE, "CONTROL_MODE" },
+	{ Attribute::PID_TARGET_TEMPERATURE, "PID_TARGET_TEMPERATURE" },
+	{ Attribute::PID_PROPORTIONAL_GAIN, "PID_PROPORTIONAL_GAIN" },
+	{ Attribute::PID_INTEGRAL_GAIN, "PID_INTEGRAL_GAIN" },
+	{ Attribute::PID_DERIVATIVE_GAIN, "PID_DERIVATIVE_GAIN" },
+	{ Attribute::PID_SLEW_RATE, "PID_SLEW_RATE" },
+	{ Attribute::PID_OUTPUT_HYSTERESIS, "PID_OUTPUT_HYSTERESIS" },
+	{ Attribute::TEMPERATURE_FILTER, "TEMPERATURE_FILTER" },
+	{ Attribute::TEMPERATURE_FILTER_WINDOW, "TEMPERATURE_FILTER_WINDOW" },
+	{ Attribute::TEMPERATURE_FILTER_EMA_SHIFT, "TEMPERATURE_FILTER_EMA_SHIFT" }
+};
+
+constexpr bool isInOrder() {
+	for( std::size_t i = 0; i != ATTRIBUTE_COUNT; i++ ) {
+		if( static_cast<std::size_t>( ATTRIBUTE_NAMES[i].attribute ) != i ) return false;
+	}
+	return true;
+}
+static_assert(
+	std::size( ATTRIBUTE_NAMES ) == ATTRIBUTE_COUNT && isInOrder(),
+	"Each attribute needs exactly one name in the order of the enumeration"
+);
+
+constexpr PerfectHash<ATTRIBUTE_COUNT>::KeySeq getAttributeKeys() {
+	PerfectHash<ATTRIBUTE_COUNT>::KeySeq keys{};
+	for( std::size_t i = 0; i != ATTRIBUTE_COUNT; i++ )
+		keys[i] = ATTRIBUTE_NAMES[i].name;
+	return keys;
+}
+
+/**
+ * Maps the name of an attribute onto the attribute; unknown names map onto
+ * `Attribute::UNKNOWN`.
+ */
+constexpr PerfectHash<ATTRIBUTE_COUNT> ATTRIBUTE_TABLE( getAttributeKeys() );
+static_assert( PerfectHash<ATTRIBUTE_COUNT>::NOT_FOUND == ATTRIBUTE_COUNT );
+
+constexpr char const* getAttributeName( Attribute const attribute ) {
+	return ATTRIBUTE_NAMES[static_cast<std::size_t>( attribute )].name.data();
+}
+
+Attribute findAttribute( std::string_view const name ) {
+	return static_cast<Attribute>( ATTRIBUTE_TABLE.find( name ) );
+}
+
+bool isSpace( char const c ) {
+	return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+bool isAttributeCharacter( char const c ) {
+	return ( c >= 'A' && c <= 'Z' ) || ( c >= 'a' && c <= 'z' ) || c == '_';
+}
+
+bool isDigit( char const c ) {
+	return c >= '0' && c <= '9';
+}
+
+/**
+ * The largest number of milliseconds which fits into a `Duration`.
+ */
+constexpr unsigned long MAX_DURATION = std::numeric_limits<Duration::rep>::max();
+
+/**
+ * @throw std::out_of_range if the number exceeds `PWMActuator::MAX_PWM_VALUE`
+ */
+PwmValue toPwmValue( unsigned long const number ) {
+	if( number > PWMActuator::MAX_PWM_VALUE )
+		throw std::out_of_range( "PWM value exceeds " + std::to_string( PWMActuator::MAX_PWM_VALUE ) );
+	return static_cast<PwmValue>( number );
+}
+
+}
+
 // General global settings which should only appear once
 char const* const RuntimeConfig::SYSTEM_CONFIG_FILE_PATH = "/etc/amdgpu-fanctrl.conf";
 char const* const RuntimeConfig::USER_CONFIG_FILE_PATH = "/~/.local/amdgpu-fanctrl.conf";
-char const* const RuntimeConfig::LOG_TRESHOLD_ATTRIBUTE = "LOG_TRESHOLD";
-char const* const RuntimeConfig::CONTROL_INTERVAL_ATTRIBUTE = "CONTROL_INTERVAL";
+char const* const RuntimeConfig::LOG_TRESHOLD_ATTRIBUTE = getAttributeName( Attribute::LOG_TRESHOLD );
+LogBuffer::Severity const RuntimeConfig::LOG_TRESHOLD_DEFAULT_VALUE( LogBuffer::DEFAULT_LOG_LEVEL );
+char const* const RuntimeConfig::LOG_ASYNCHRONOUS_ATTRIBUTE = getAttributeName( Attribute::LOG_ASYNCHRONOUS );
+bool const        RuntimeConfig::LOG_ASYNCHRONOUS_DEFAULT_VALUE( false );
+char const* const RuntimeConfig::CONTROL_INTERVAL_ATTRIBUTE = getAttributeName( Attribute::CONTROL_INTERVAL );
 Duration const    RuntimeConfig::CONTROL_INTERVAL_DEFAULT_VALUE( Duration( 1000 ) );
+char const* const RuntimeConfig::MAX_CONTROL_INTERVAL_ATTRIBUTE = getAttributeName( Attribute::MAX_CONTROL_INTERVAL );
+Duration const    RuntimeConfig::MAX_CONTROL_INTERVAL_DEFAULT_VALUE( Duration( 0 ) );
+char const* const RuntimeConfig::TEMPERATURE_ALARM_WAKEUP_ATTRIBUTE = getAttributeName( Attribute::TEMPERATURE_ALARM_WAKEUP );
+bool const        RuntimeConfig::TEMPERATURE_ALARM_WAKEUP_DEFAULT_VALUE( false );
+char const* const RuntimeConfig::TEMPERATURE_ACQUISITION_ATTRIBUTE = getAttributeName( Attribute::TEMPERATURE_ACQUISITION );
+TemperatureAcquisition::Backend const RuntimeConfig::TEMPERATURE_ACQUISITION_DEFAULT_VALUE( TemperatureAcquisition::Backend::PREAD );
+char const* const RuntimeConfig::TELEMETRY_FILE_PATH_ATTRIBUTE = getAttributeName( Attribute::TELEMETRY_FILE_PATH );
+char const* const RuntimeConfig::TELEMETRY_FILE_PATH_DEFAULT_VALUE = "";
+char const* const RuntimeConfig::TELEMETRY_RECORD_COUNT_ATTRIBUTE = getAttributeName( Attribute::TELEMETRY_RECORD_COUNT );
+unsigned long const RuntimeConfig::TELEMETRY_RECORD_COUNT_DEFAULT_VALUE( 65536 );
+char const* const RuntimeConfig::METRICS_SOCKET_PATH_ATTRIBUTE = getAttributeName( Attribute::METRICS_SOCKET_PATH );
+char const* const RuntimeConfig::METRICS_SOCKET_PATH_DEFAULT_VALUE = "";
+char const* const RuntimeConfig::HWMON_CACHE_FILE_PATH_ATTRIBUTE = getAttributeName( Attribute::HWMON_CACHE_FILE_PATH );
+char const* const RuntimeConfig::HWMON_CACHE_FILE_PATH_DEFAULT_VALUE = "/run/amdgpu-fanctrl/hwmon.cache";
+char const* const RuntimeConfig::CONFIG_FILE_WATCH_ATTRIBUTE = getAttributeName( Attribute::CONFIG_FILE_WATCH );
+bool const        RuntimeConfig::CONFIG_FILE_WATCH_DEFAULT_VALUE( true );
+char const* const RuntimeConfig::ADMIN_SOCKET_PATH_ATTRIBUTE = getAttributeName( Attribute::ADMIN_SOCKET_PATH );
+char const* const RuntimeConfig::ADMIN_SOCKET_PATH_DEFAULT_VALUE = "";
+char const* const RuntimeConfig::MAX_PWM_OVERRIDE_DURATION_ATTRIBUTE = getAttributeName( Attribute::MAX_PWM_OVERRIDE_DURATION );
+Duration const    RuntimeConfig::MAX_PWM_OVERRIDE_DURATION_DEFAULT_VALUE( Duration( 600000 ) );
+char const* const RuntimeConfig::REALTIME_PRIORITY_ATTRIBUTE = getAttributeName( Attribute::REALTIME_PRIORITY );
+int const         RuntimeConfig::REALTIME_PRIORITY_DEFAULT_VALUE( 0 );
+char const* const RuntimeConfig::CPU_AFFINITY_ATTRIBUTE = getAttributeName( Attribute::CPU_AFFINITY );
 
 // Settings which define sensor/actuators and should be iterated with a
 // suffix ".<number>" for each sensor/actuator
 char const* const RuntimeConfig::
-	TEMPERATURE_SENSOR_PATH_ATTRIBUTE = "TEMPERATURE_SENSOR_PATH";
+	TEMPERATURE_SENSOR_PATH_ATTRIBUTE = getAttributeName( Attribute::TEMPERATURE_SENSOR_PATH );
 char const* const RuntimeConfig::
-	PWM_ACTUATOR_PATH_ATTRIBUTE = "PWM_ACTUATOR_PATH";
+	PWM_ACTUATOR_PATH_ATTRIBUTE = getAttributeName( Attribute::PWM_ACTUATOR_PATH );
+std::size_t const RuntimeConfig::MAX_INDEX( 255 );
+std::size_t const RuntimeConfig::
+	UNDEFINED_INDEX( std::numeric_limits<std::size_t>::max() );
 
 // Settings which define a controller ans should be iterated with a
 // suffix ".<number>" for each controller
 char const* const  RuntimeConfig::ControllerConfig::
-	TEMPERATURE_SENSOR_INDEX_ATTRIBUTE = "TEMPERATURE_SENSOR_INDEX";
+	TEMPERATURE_SENSOR_INDEX_ATTRIBUTE = getAttributeName( Attribute::TEMPERATURE_SENSOR_INDEX );
 char const* const  RuntimeConfig::ControllerConfig::
-	PWM_ACTUATOR_INDEX_ATTRIBUTE = "PWM_ACTUATOR_INDEX";
+	TEMPERATURE_AGGREGATION_ATTRIBUTE = getAttributeName( Attribute::TEMPERATURE_AGGREGATION );
+TemperatureInput::Aggregation const RuntimeConfig::ControllerConfig::
+	TEMPERATURE_AGGREGATION_DEFAULT_VALUE( TemperatureInput::Aggregation::MAX );
 char const* const  RuntimeConfig::ControllerConfig::
-	UPWARD_TEMPERATURE_HYSTERESIS_ATTRIBUTE = "UPWARD_TEMPERATURE_HYSTERESIS";
+	TEMPERATURE_SENSOR_WEIGHTS_ATTRIBUTE = getAttributeName( Attribute::TEMPERATURE_SENSOR_WEIGHTS );
+char const* const  RuntimeConfig::ControllerConfig::
+	TEMPERATURE_SENSOR_LIMITS_ATTRIBUTE = getAttributeName( Attribute::TEMPERATURE_SENSOR_LIMITS );
+char const* const  RuntimeConfig::ControllerConfig::
+	PWM_ACTUATOR_INDEX_ATTRIBUTE = getAttributeName( Attribute::PWM_ACTUATOR_INDEX );
+char const* const  RuntimeConfig::ControllerConfig::
+	UPWARD_TEMPERATURE_HYSTERESIS_ATTRIBUTE = getAttributeName( Attribute::UPWARD_TEMPERATURE_HYSTERESIS );
 Temperature const  RuntimeConfig::ControllerConfig::
 	UPWARD_TEMPERATURE_HYSTERESIS_DEFAULT_VALUE( 500 );
 char const* const  RuntimeConfig::ControllerConfig::
-	DOWNWARD_TEMPERATURE_HYSTERESIS_ATTRIBUTE = "DOWNWARD_TEMPERATURE_HYSTERESIS";
+	DOWNWARD_TEMPERATURE_HYSTERESIS_ATTRIBUTE = getAttributeName( Attribute::DOWNWARD_TEMPERATURE_HYSTERESIS );
 Temperature const  RuntimeConfig::ControllerConfig::
 	DOWNWARD_TEMPERATURE_HYSTERESIS_DEFAULT_VALUE( 3000 );
 char const* const  RuntimeConfig::ControllerConfig::
-	BASE_CONTROL_TEMPERATURE_ATTRIBUTE = "BASE_CONTROL_TEMPERATURE";
+	BASE_CONTROL_TEMPERATURE_ATTRIBUTE = getAttributeName( Attribute::BASE_CONTROL_TEMPERATURE );
 char const* const  RuntimeConfig::ControllerConfig::
-	BASE_CONTROL_PWM_ATTRIBUTE = "BASE_CONTROL_PWM";
+	BASE_CONTROL_PWM_ATTRIBUTE = getAttributeName( Attribute::BASE_CONTROL_PWM );
 ControlPoint const RuntimeConfig::ControllerConfig::
 	BASE_CONTROL_POINT_DEFAULT_VALUE( { 40000, 70} );
 char const* const  RuntimeConfig::ControllerConfig::
-	MIN_CONTROL_TEMPERATURE_ATTRIBUTE = "LOW_CONTROL_TEMPERATURE";
+	MIN_CONTROL_TEMPERATURE_ATTRIBUTE = getAttributeName( Attribute::MIN_CONTROL_TEMPERATURE );
 char const* const  RuntimeConfig::ControllerConfig::
-	MIN_CONTROL_PWM_ATTRIBUTE = "LOW_CONTROL_PWM";
+	MIN_CONTROL_PWM_ATTRIBUTE = getAttributeName( Attribute::MIN_CONTROL_PWM );
 ControlPoint const RuntimeConfig::ControllerConfig::
 	MIN_CONTROL_POINT_DEFAULT_VALUE( { 45000, 57} );
 char const* const  RuntimeConfig::ControllerConfig::
-	MAX_CONTROL_TEMPERATURE_ATTRIBUTE = "HIGH_CONTROL_TEMPERATURE";
+	MAX_CONTROL_TEMPERATURE_ATTRIBUTE = getAttributeName( Attribute::MAX_CONTROL_TEMPERATURE );
 char const* const  RuntimeConfig::ControllerConfig::
-	MAX_CONTROL_PWM_ATTRIBUTE = "HIGH_CONTROL_PWM";
+	MAX_CONTROL_PWM_ATTRIBUTE = getAttributeName( Attribute::MAX_CONTROL_PWM );
 ControlPoint const RuntimeConfig::ControllerConfig::
 	MAX_CONTROL_POINT_DEFAULT_VALUE( { 95000, 255} );
+char const* const  RuntimeConfig::ControllerConfig::
+	CONTROL_CURVE_ATTRIBUTE = getAttributeName( Attribute::CONTROL_CURVE );
+char const* const  RuntimeConfig::ControllerConfig::
+	CONTROL_MODE_ATTRIBUTE = getAttributeName( Attribute::CONTROL_MODE );
+RuntimeConfig::ControllerConfig::ControlMode const RuntimeConfig::ControllerConfig::
+	CONTROL_MODE_DEFAULT_VALUE( ControlMode::CURVE );
+char const* const  RuntimeConfig::ControllerConfig::
+	PID_TARGET_TEMPERATURE_ATTRIBUTE = getAttributeName( Attribute::PID_TARGET_TEMPERATURE );
+Temperature const  RuntimeConfig::ControllerConfig::
+	PID_TARGET_TEMPERATURE_DEFAULT_VALUE( 70000 );
+char const* const  RuntimeConfig::ControllerConfig::
+	PID_PROPORTIONAL_GAIN_ATTRIBUTE = getAttributeName( Attribute::PID_PROPORTIONAL_GAIN );
+double const       RuntimeConfig::ControllerConfig::
+	PID_PROPORTIONAL_GAIN_DEFAULT_VALUE( 8.0 );
+char const* const  RuntimeConfig::ControllerConfig::
+	PID_INTEGRAL_GAIN_ATTRIBUTE = getAttributeName( Attribute::PID_INTEGRAL_GAIN );
+double const       RuntimeConfig::ControllerConfig::
+	PID_INTEGRAL_GAIN_DEFAULT_VALUE( 0.5 );
+char const* const  RuntimeConfig::ControllerConfig::
+	PID_DERIVATIVE_GAIN_ATTRIBUTE = getAttributeName( Attribute::PID_DERIVATIVE_GAIN );
+double const       RuntimeConfig::ControllerConfig::
+	PID_DERIVATIVE_GAIN_DEFAULT_VALUE( 0.0 );
+char const* const  RuntimeConfig::ControllerConfig::
+	PID_SLEW_RATE_ATTRIBUTE = getAttributeName( Attribute::PID_SLEW_RATE );
+PwmValue const     RuntimeConfig::ControllerConfig::
+	PID_SLEW_RATE_DEFAULT_VALUE( 10 );
+char const* const  RuntimeConfig::ControllerConfig::
+	PID_OUTPUT_HYSTERESIS_ATTRIBUTE = getAttributeName( Attribute::PID_OUTPUT_HYSTERESIS );
+PwmValue const     RuntimeConfig::ControllerConfig::
+	PID_OUTPUT_HYSTERESIS_DEFAULT_VALUE( 2 );
+char const* const  RuntimeConfig::ControllerConfig::
+	TEMPERATURE_FILTER_ATTRIBUTE = getAttributeName( Attribute::TEMPERATURE_FILTER );
+TemperatureFilter::Mode const RuntimeConfig::ControllerConfig::
+	TEMPERATURE_FILTER_DEFAULT_VALUE( TemperatureFilter::Mode::NONE );
+char const* const  RuntimeConfig::ControllerConfig::
+	TEMPERATURE_FILTER_WINDOW_ATTRIBUTE = getAttributeName( Attribute::TEMPERATURE_FILTER_WINDOW );
+unsigned const     RuntimeConfig::ControllerConfig::
+	TEMPERATURE_FILTER_WINDOW_DEFAULT_VALUE( 3 );
+char const* const  RuntimeConfig::ControllerConfig::
+	TEMPERATURE_FILTER_EMA_SHIFT_ATTRIBUTE = getAttributeName( Attribute::TEMPERATURE_FILTER_EMA_SHIFT );
+unsigned const     RuntimeConfig::ControllerConfig::
+	TEMPERATURE_FILTER_EMA_SHIFT_DEFAULT_VALUE( 1 );
 
 RuntimeConfig::ConfigLine::ConfigLine(std::string const& line) :
 	attribute(),
-	index(-1),
+	index(UNDEFINED_INDEX),
 	value(),
 	valid(false),
-	failed(false)
+	failed(false),
+	errorColumn(0),
+	errorMessage(nullptr)
 {
-	static std::regex const commentOrEmpty("^\\s*($|#])");
-	// This regex has three caputing groups: attribute, index, value
-	// The value-group is special, because we want to support values with
-	// spaces in the middle, but spaces at the beginning and end shall be removed,
-	// i.e. a valid line could look like this
-	//
-	// Name = John Dear
-	//
-	// In this case the value is "John Dear" with a space between first and
-	// last name, but any preceeding blank (i.e. between the equal sign and the
-	// first letter) as well as any spurious blank at the end shall be ignored.
-	// The regex `\\s*((?:\\s*\\S+)+)\\s*$`works, because regex are greedy.
-	// The first `\\s*\\ catches all preceeding blanks greedily.
-	// The actual value is captured by `((?:\\s*\\S+)+)` with a list of
-	// inner sub-expressions that allow optional, seperating blanks at the
-	// beginning but must at least contain a non-space at the end.
-	static std::regex const attrIdxValuePair("^\\s*([_A-Za-z]+)(?:\\.(\\d+))?\\s*=\\s*((?:\\s*\\S+)+)\\s*$");
-	std::smatch pieces;
-
-	if( std::regex_match(line, commentOrEmpty) )
+	std::string::size_type const size = line.size();
+	std::string::size_type pos = 0;
+	while( pos != size && isSpace( line[pos] ) ) pos++;
+	if( pos == size || line[pos] == '#' )
+		return;
+
+	std::string::size_type const attributeStart = pos;
+	while( pos != size && isAttributeCharacter( line[pos] ) ) pos++;
+	std::string::size_type const attributeEnd = pos;
+	if( attributeEnd == attributeStart ) {
+		fail( pos, "expected attribute" );
 		return;
-	if( std::regex_match(line, pieces, attrIdxValuePair) ) {
-		if( pieces.size() == 2 ) {
-			attribute = pieces[0];
-			value = pieces[1];
-			valid = true;
-		} else if( pieces.size() == 3 ) {
-			attribute = pieces[0];
-			index = std::stoi(pieces[1]);
-			value = pieces[2];
-			valid = true;
-		} else {
-			failed = true;
+	}
+
+	if( pos != size && line[pos] == '.' ) {
+		pos++;
+		std::string::size_type const indexStart = pos;
+		std::size_t idx = 0;
+		for( ; pos != size && isDigit( line[pos] ); pos++ ) {
+			// Saturate, such that an overlong index is reported as being out
+			// of range instead of overflowing
+			if( idx <= MAX_INDEX ) idx = idx * 10 + ( line[pos] - '0' );
+		}
+		if( pos == indexStart ) {
+			fail( pos, "expected index" );
+			return;
 		}
+		index = std::min( idx, MAX_INDEX + 1 );
+	}
+
+	while( pos != size && isSpace( line[pos] ) ) pos++;
+	if( pos == size || line[pos] != '=' ) {
+		fail( pos, "expected '='" );
+		return;
 	}
+	pos++;
+	while( pos != size && isSpace( line[pos] ) ) pos++;
+	std::string::size_type end = size;
+	while( end != pos && isSpace( line[end - 1] ) ) end--;
+	if( pos == end ) {
+		fail( pos, "expected value" );
+		return;
+	}
+
+	attribute.assign( line, attributeStart, attributeEnd - attributeStart );
+	value.assign( line, pos, end - pos );
+	valid = true;
+}
+
+/**
+ * Returns the value as a decimal number.
+ *
+ * Unlike `std::stoul`, a sign is not accepted, as a negative number would
+ * silently wrap around.
+ *
+ * @throw std::invalid_argument if the value is not a decimal number
+ * @throw std::out_of_range if the value exceeds `max`
+ */
+unsigned long RuntimeConfig::ConfigLine::getValueAsUL( unsigned long const max ) const {
+	if( !std::all_of( value.begin(), value.end(), isDigit ) )
+		throw std::invalid_argument( "Not a decimal number: " + value );
+	unsigned long const number = std::stoul( value );
+	if( number > max )
+		throw std::out_of_range( "Number out of range: " + value );
+	return number;
+}
+
+void RuntimeConfig::ConfigLine::fail(std::string::size_type const pos, char const* const message) {
 	failed = true;
+	errorColumn = pos + 1;
+	errorMessage = message;
+	index = UNDEFINED_INDEX;
 }
 
+RuntimeConfig::Ptr RuntimeConfig::current;
+LogBuffer::Severity RuntimeConfig::logTresholdOverride( LogBuffer::DEFAULT_LOG_LEVEL );
+bool RuntimeConfig::isLogTresholdOverridden( false );
 
 RuntimeConfig::RuntimeConfig() {
 	loadDefaults();
 }
 
-RuntimeConfig& RuntimeConfig::get() {
-	static RuntimeConfig singleton;
-	return singleton;
+/**
+ * Creates a snapshot from the user or system configuration file, see
+ * `loadFromFile()`.
+ */
+RuntimeConfig::Ptr RuntimeConfig::load() {
+	std::shared_ptr<RuntimeConfig> config( std::make_shared<RuntimeConfig>() );
+	config->loadFromFile();
+	return config;
+}
+
+/**
+ * Creates a snapshot from an explicitly given file.
+ *
+ * @throw std::runtime_error if the file cannot be opened
+ */
+RuntimeConfig::Ptr RuntimeConfig::load( std::string const& filePath ) {
+	std::shared_ptr<RuntimeConfig> config( std::make_shared<RuntimeConfig>() );
+	config->loadFromFile( filePath );
+	return config;
+}
+
+/**
+ * Returns the most recently published snapshot or `nullptr` if none has
+ * been published yet.
+ *
+ * May be called from any thread; the returned snapshot stays valid for as
+ * long as the caller holds it, even if a newer snapshot is published in the
+ * meantime.
+ */
+RuntimeConfig::Ptr RuntimeConfig::getCurrent() {
+	return std::atomic_load( &current );
+}
+
+/**
+ * Publishes a snapshot, see `getCurrent`.
+ *
+ * The previous snapshot is released once its last holder has dropped it.
+ */
+void RuntimeConfig::publish( Ptr const& config ) {
+	std::atomic_store( &current, config );
+}
+
+/**
+ * Overrides `LOG_TRESHOLD` of all snapshots, e.g. by a command line option.
+ *
+ * Like the other log settings, the override takes effect once the next
+ * snapshot is activated.
+ */
+void RuntimeConfig::overrideLogTreshold( LogBuffer::Severity const treshold ) {
+	logTresholdOverride = treshold;
+	isLogTresholdOverridden = true;
+}
+
+/**
+ * Creates a copy of this snapshot in which the fan curve of a single
+ * controller is replaced.
+ *
+ * @param value the control points in the syntax of `CONTROL_CURVE`
+ * @throw std::out_of_range if the controller does not exist
+ * @throw std::invalid_argument if the curve is malformed or invalid
+ */
+RuntimeConfig::Ptr RuntimeConfig::withControlCurve( ControllerConfigIdx const idx, std::string const& value ) const {
+	if( idx >= controllerConfigs.size() )
+		throw std::out_of_range( "No such controller" );
+	FanCurve::ControlPointSeq const points( parseControlCurve( value ) );
+	std::shared_ptr<RuntimeConfig> config( new RuntimeConfig( *this ) );
+	config->controllerConfigs[idx].controlCurvePoints = points;
+	config->controllerConfigs[idx].compileCurve();
+	return config;
 }
 
 void RuntimeConfig::loadDefaults() {
+	logTreshold = LOG_TRESHOLD_DEFAULT_VALUE;
+	logAsynchronous = LOG_ASYNCHRONOUS_DEFAULT_VALUE;
 	controlInterval = CONTROL_INTERVAL_DEFAULT_VALUE;
+	maxControlInterval = MAX_CONTROL_INTERVAL_DEFAULT_VALUE;
+	temperatureAlarmWakeup = TEMPERATURE_ALARM_WAKEUP_DEFAULT_VALUE;
+	temperatureAcquisition = TEMPERATURE_ACQUISITION_DEFAULT_VALUE;
+	telemetryFilePath = TELEMETRY_FILE_PATH_DEFAULT_VALUE;
+	telemetryRecordCount = TELEMETRY_RECORD_COUNT_DEFAULT_VALUE;
+	metricsSocketPath = METRICS_SOCKET_PATH_DEFAULT_VALUE;
+	hwmonCacheFilePath = HWMON_CACHE_FILE_PATH_DEFAULT_VALUE;
+	configFileWatch = CONFIG_FILE_WATCH_DEFAULT_VALUE;
+	adminSocketPath = ADMIN_SOCKET_PATH_DEFAULT_VALUE;
+	maxPwmOverrideDuration = MAX_PWM_OVERRIDE_DURATION_DEFAULT_VALUE;
+	realtimePriority = REALTIME_PRIORITY_DEFAULT_VALUE;
+	cpuAffinity.clear();
+	filePath.clear();
 	temperatureSensorPaths.clear();
 	pwmActuatorPaths.clear();
 	controllerConfigs.clear();
@@ -120,95 +495,525 @@ void RuntimeConfig::loadDefaults() {
 void RuntimeConfig::loadFromFile() {
 	std::ifstream configFileStream;
 	configFileStream.open( USER_CONFIG_FILE_PATH );
-	if ( !configFileStream.is_open() )
+	if ( configFileStream.is_open() ) {
+		filePath = USER_CONFIG_FILE_PATH;
+	} else {
 		configFileStream.open( SYSTEM_CONFIG_FILE_PATH );
+		if ( !configFileStream.is_open() )
+			return;
+		filePath = SYSTEM_CONFIG_FILE_PATH;
+	}
+	loadFromStream( configFileStream );
+}
+
+/**
+ * Loads the configuration from an explicitly given file.
+ *
+ * Other than `loadFromFile()`, a missing file is an error.
+ */
+void RuntimeConfig::loadFromFile( std::string const& path ) {
+	std::ifstream configFileStream;
+	configFileStream.open( path );
 	if ( !configFileStream.is_open() )
-		return;
-	configFileStream.exceptions( std::ifstream::failbit | std::ifstream::badbit );
+		throw std::runtime_error( "Cannot open configuration file " + path );
+	filePath = path;
+	loadFromStream( configFileStream );
+}
+
+/**
+ * Loads the configuration from a stream.
+ *
+ * The settings of the stream are added to the current settings; invalid
+ * lines are logged and skipped.
+ */
+void RuntimeConfig::loadFromStream( std::istream& configFileStream ) {
+	LogStream& log( LogStream::get() );
+	// Note, `failbit` must not raise an exception as `std::getline` sets it
+	// at the end of the file
+	configFileStream.exceptions( std::istream::badbit );
 
+	unsigned long lineNo = 0;
 	for( std::string line; std::getline(configFileStream, line); ) {
+		lineNo++;
 		ConfigLine configLine(line);
+		if( configLine.hasFailed() ) {
+			log << LogBuffer::Severity::WARNING
+			    << "Syntax error in line " << lineNo << ", column " << configLine.getErrorColumn()
+			    << " of configuration: " << configLine.getErrorMessage() << std::flush;
+			continue;
+		}
 		if ( !configLine.isValid() ) continue;
-
-		if( configLine.getAttribute().compare( LOG_TRESHOLD_ATTRIBUTE ) == 0 ) {
-			loadLogTreshold( configLine.getValue() );
+		if( configLine.hasIndex() && configLine.getIndex() > MAX_INDEX ) {
+			log << LogBuffer::Severity::WARNING
+			    << "Index out of range in line " << lineNo << " of configuration" << std::flush;
+			continue;
 		}
-		if( configLine.getAttribute().compare( CONTROL_INTERVAL_ATTRIBUTE ) == 0 ) {
-			controlInterval = Duration( configLine.getValueAsUL() );
+		Attribute const attribute = findAttribute( configLine.getAttribute() );
+		if( attribute == Attribute::UNKNOWN ) {
+			log << LogBuffer::Severity::WARNING
+			    << "Unknown attribute " << configLine.getAttribute()
+			    << " in line " << lineNo << " of configuration" << std::flush;
+			continue;
 		}
 
-
-		if(
-				configAttribute.find( TEMPERATURE_SENSOR_PATH_ATTRIBUTE ) !=
-				std::string::npos
-		) {
-				std::istringstream attributeStream( configAttribute );
-				std::string configIdx;
-				std::getline( attributeStream, configIdx, '.');
-				std::getline( attributeStream, configIdx );
+		try {
+			loadAttribute( attribute, configLine );
+		} catch( std::logic_error const& e ) {
+			// `std::stoul` throws `std::invalid_argument` or `std::out_of_range`
+			log << LogBuffer::Severity::WARNING
+			    << "Invalid value in line " << lineNo << " of configuration" << std::flush;
 		}
+	}
+
+	// A maximum below the interval disables the adaptation
+	if( maxControlInterval < controlInterval )
+		maxControlInterval = controlInterval;
+	resolveControllerDefaults();
+}
 
+/**
+ * Stores the value of a single configuration line.
+ *
+ * Settings which may be iterated but appear without a suffix ".<number>"
+ * refer to the first element, i.e. a configuration for a single controller
+ * does not need any suffix at all.
+ */
+void RuntimeConfig::loadAttribute( Attribute const attribute, ConfigLine const& configLine ) {
+	std::size_t const idx = configLine.hasIndex() ? configLine.getIndex() : 0;
 
+	switch( attribute ) {
+		case Attribute::LOG_TRESHOLD:
+			logTreshold = parseLogTreshold( configLine.getValue() );
+			break;
+		case Attribute::LOG_ASYNCHRONOUS:
+			logAsynchronous = configLine.getValueAsUL() != 0;
+			break;
+		case Attribute::CONTROL_INTERVAL:
+			// A zero interval would turn the periodic timer into a one-shot
+			if( configLine.getValueAsUL( MAX_DURATION ) == 0 )
+				throw std::invalid_argument( "Control interval must not be zero" );
+			controlInterval = Duration( configLine.getValueAsUL( MAX_DURATION ) );
+			break;
+		case Attribute::MAX_CONTROL_INTERVAL:
+			maxControlInterval = Duration( configLine.getValueAsUL( MAX_DURATION ) );
+			break;
+		case Attribute::TEMPERATURE_ALARM_WAKEUP:
+			temperatureAlarmWakeup = configLine.getValueAsUL() != 0;
+			break;
+		case Attribute::TEMPERATURE_ACQUISITION:
+			temperatureAcquisition = parseTemperatureAcquisition( configLine.getValue() );
+			break;
+		case Attribute::TELEMETRY_FILE_PATH:
+			telemetryFilePath = configLine.getValue();
+			break;
+		case Attribute::TELEMETRY_RECORD_COUNT:
+			telemetryRecordCount = configLine.getValueAsUL();
+			break;
+		case Attribute::METRICS_SOCKET_PATH:
+			metricsSocketPath = configLine.getValue();
+			break;
+		case Attribute::HWMON_CACHE_FILE_PATH:
+			hwmonCacheFilePath = configLine.getValue();
+			break;
+		case Attribute::CONFIG_FILE_WATCH:
+			configFileWatch = configLine.getValueAsUL() != 0;
+			break;
+		case Attribute::ADMIN_SOCKET_PATH:
+			adminSocketPath = configLine.getValue();
+			break;
+		case Attribute::MAX_PWM_OVERRIDE_DURATION:
+			maxPwmOverrideDuration = Duration( configLine.getValueAsUL( MAX_DURATION ) );
+			break;
+		case Attribute::REALTIME_PRIORITY:
+			realtimePriority = static_cast<int>( std::min( configLine.getValueAsUL(), 99ul ) );
+			break;
+		case Attribute::CPU_AFFINITY:
+			cpuAffinity = parseList( configLine.getValue() );
+			break;
+		case Attribute::TEMPERATURE_SENSOR_PATH:
+			if( temperatureSensorPaths.size() <= idx )
+				temperatureSensorPaths.resize( idx + 1 );
+			temperatureSensorPaths[idx] = configLine.getValue();
+			break;
+		case Attribute::PWM_ACTUATOR_PATH:
+			if( pwmActuatorPaths.size() <= idx )
+				pwmActuatorPaths.resize( idx + 1 );
+			pwmActuatorPaths[idx] = configLine.getValue();
+			break;
+		default:
+			loadControllerAttribute( attribute, configLine );
+	}
+}
 
-		if( configAttribute.find( ControllerConfig::UPWARD_TEMPERATURE_HYSTERESIS_ATTRIBUTE ) != std::string::npos ) {
-				valueStream >> upwardTemperatureHysteresis;
+/**
+ * Stores the value of a single configuration line which belongs to a
+ * controller.
+ *
+ * The value is parsed before the sequence of controllers is possibly
+ * enlarged, such that an invalid value does not create a controller.
+ */
+void RuntimeConfig::loadControllerAttribute( Attribute const attribute, ConfigLine const& configLine ) {
+	std::size_t const idx = configLine.hasIndex() ? configLine.getIndex() : 0;
+	std::string const& value( configLine.getValue() );
+
+	switch( attribute ) {
+		case Attribute::CONTROL_CURVE: {
+			FanCurve::ControlPointSeq const points( parseControlCurve( value ) );
+			provideControllerConfig( idx ).controlCurvePoints = points;
+			return;
+		}
+		case Attribute::CONTROL_MODE: {
+			ControllerConfig::ControlMode const mode( parseControlMode( value ) );
+			provideControllerConfig( idx ).controlMode = mode;
+			return;
 		}
-		if( configAttribute.find( ControllerConfig::DOWNWARD_TEMPERATURE_HYSTERESIS_ATTRIBUTE ) != std::string::npos ) {
-				valueStream >> downwardTemperatureHysteresis;
+		case Attribute::TEMPERATURE_FILTER: {
+			TemperatureFilter::Mode const mode( parseTemperatureFilter( value ) );
+			provideControllerConfig( idx ).temperatureFilter = mode;
+			return;
 		}
-		if( configAttribute.find( ControllerConfig::BASE_CONTROL_TEMPERATURE_ATTRIBUTE ) != std::string::npos ) {
-				valueStream >> baseControlPoint.temp;
+		case Attribute::TEMPERATURE_SENSOR_INDEX: {
+			std::vector<unsigned long> const indices( parseList( value ) );
+			provideControllerConfig( idx ).setTemperatureSensorIdxSeq(
+				TemperatureSensorIdxSeq( indices.begin(), indices.end() )
+			);
+			return;
 		}
-		if( configAttribute.find( ControllerConfig::BASE_CONTROL_PWM_ATTRIBUTE ) != std::string::npos ) {
-				valueStream >> baseControlPoint.pwmValue;
+		case Attribute::TEMPERATURE_AGGREGATION: {
+			TemperatureInput::Aggregation const aggregation( parseTemperatureAggregation( value ) );
+			provideControllerConfig( idx ).temperatureAggregation = aggregation;
+			return;
 		}
-		if( configAttribute.find( ControllerConfig::MIN_CONTROL_TEMPERATURE_ATTRIBUTE ) != std::string::npos ) {
-				valueStream >> lowControlPoint.temp;
+		case Attribute::TEMPERATURE_SENSOR_WEIGHTS: {
+			std::vector<unsigned long> const weights( parseList( value ) );
+			provideControllerConfig( idx ).temperatureSensorWeights = weights;
+			return;
 		}
-		if( configAttribute.find( ControllerConfig::MIN_CONTROL_PWM_ATTRIBUTE ) != std::string::npos ) {
-				valueStream >> lowControlPoint.pwmValue;
+		case Attribute::TEMPERATURE_SENSOR_LIMITS: {
+			std::vector<unsigned long> const limits( parseList( value ) );
+			provideControllerConfig( idx ).temperatureSensorLimits.assign( limits.begin(), limits.end() );
+			return;
 		}
-		if( configAttribute.find( ControllerConfig::MAX_CONTROL_TEMPERATURE_ATTRIBUTE ) != std::string::npos ) {
-				valueStream >> highControlPoint.temp;
+		case Attribute::PID_PROPORTIONAL_GAIN: {
+			double const gain = parseGain( value );
+			provideControllerConfig( idx ).pidProportionalGain = gain;
+			return;
 		}
-		if( configAttribute.find( ControllerConfig::MAX_CONTROL_PWM_ATTRIBUTE ) != std::string::npos ) {
-				valueStream >> highControlPoint.pwmValue;
+		case Attribute::PID_INTEGRAL_GAIN: {
+			double const gain = parseGain( value );
+			provideControllerConfig( idx ).pidIntegralGain = gain;
+			return;
 		}
+		case Attribute::PID_DERIVATIVE_GAIN: {
+			double const gain = parseGain( value );
+			provideControllerConfig( idx ).pidDerivativeGain = gain;
+			return;
+		}
+		default:
+			break;
 	}
 
-	std::string configAttribute;
-	std::string configValue;
-	while ( !configFileStream.eof() ) {
-		std::getline( configFileStream, configAttribute, '=' );
-		std::getline( configFileStream, configValue);
-		std::istringstream valueStream( configValue );
-		valueStream.exceptions( std::ifstream::failbit | std::ifstream::badbit );
+	// All remaining attributes are unsigned integers of the width of a
+	// temperature or PWM value
+	unsigned long const number = configLine.getValueAsUL( std::numeric_limits<Temperature>::max() );
+	ControllerConfig& ctrCnf( provideControllerConfig( idx ) );
 
+	switch( attribute ) {
+		case Attribute::PWM_ACTUATOR_INDEX:
+			ctrCnf.setPwmActuatorIdx( number );
+			break;
+		case Attribute::UPWARD_TEMPERATURE_HYSTERESIS:
+			ctrCnf.upwardTemperatureHysteresis = number;
+			break;
+		case Attribute::DOWNWARD_TEMPERATURE_HYSTERESIS:
+			ctrCnf.downwardTemperatureHysteresis = number;
+			break;
+		case Attribute::BASE_CONTROL_TEMPERATURE:
+			ctrCnf.baseControlPoint.temp = number;
+			break;
+		case Attribute::BASE_CONTROL_PWM:
+			ctrCnf.baseControlPoint.pwmValue = toPwmValue( number );
+			break;
+		case Attribute::MIN_CONTROL_TEMPERATURE:
+			ctrCnf.minControlPoint.temp = number;
+			break;
+		case Attribute::MIN_CONTROL_PWM:
+			ctrCnf.minControlPoint.pwmValue = toPwmValue( number );
+			break;
+		case Attribute::MAX_CONTROL_TEMPERATURE:
+			ctrCnf.maxControlPoint.temp = number;
+			break;
+		case Attribute::MAX_CONTROL_PWM:
+			ctrCnf.maxControlPoint.pwmValue = toPwmValue( number );
+			break;
+		case Attribute::PID_TARGET_TEMPERATURE:
+			ctrCnf.pidTargetTemperature = number;
+			break;
+		case Attribute::PID_SLEW_RATE:
+			ctrCnf.pidSlewRate = number;
+			break;
+		case Attribute::PID_OUTPUT_HYSTERESIS:
+			ctrCnf.pidOutputHysteresis = number;
+			break;
+		case Attribute::TEMPERATURE_FILTER_WINDOW:
+			ctrCnf.temperatureFilterWindow = number;
+			break;
+		case Attribute::TEMPERATURE_FILTER_EMA_SHIFT:
+			ctrCnf.temperatureFilterEmaShift = number;
+			break;
+		default:
+			// Global attributes are handled by `loadAttribute`
+			break;
 	}
+}
 
-	logConfiguration();
+/**
+ * Returns the configuration of the controller with the given index and
+ * creates it (and all controllers with a lower index) if needed.
+ */
+RuntimeConfig::ControllerConfig& RuntimeConfig::provideControllerConfig( ControllerConfigIdx const idx ) {
+	if( controllerConfigs.size() <= idx )
+		controllerConfigs.resize( idx + 1 );
+	return controllerConfigs[idx];
 }
 
-void RuntimeConfig::loadLogTreshold( std::string const& value ) {
-	LogStream& log( LogStream::get() );
+/**
+ * Completes the controller configurations after the file has been loaded.
+ *
+ * If the configuration does not define any controller explicitly, one
+ * controller with default settings is created for each PWM actuator.
+ * A controller which does not explicitly refer to a temperature sensor
+ * or PWM actuator uses the sensor and actuator with the same index as
+ * the controller itself.
+ */
+void RuntimeConfig::resolveControllerDefaults() {
+	if( controllerConfigs.empty() )
+		controllerConfigs.resize( pwmActuatorPaths.size() );
+	for( ControllerConfigIdx i = 0; i != controllerConfigs.size(); i++ ) {
+		ControllerConfig& ctrCnf( controllerConfigs[i] );
+		if( ctrCnf.temperatureSensorIndices.empty() )
+			ctrCnf.temperatureSensorIndices.assign( 1, i );
+		if( ctrCnf.pwmActuatorIdx == UNDEFINED_INDEX )
+			ctrCnf.pwmActuatorIdx = i;
+
+		try {
+			ctrCnf.compileCurve();
+		} catch( std::invalid_argument const& e ) {
+			LogStream& log( LogStream::get() );
+			log << LogBuffer::Severity::WARNING
+			    << "Invalid fan curve of controller " << i
+			    << " (" << e.what() << "); using default control points" << std::flush;
+			ctrCnf.controlCurvePoints.clear();
+			ctrCnf.baseControlPoint = ControllerConfig::BASE_CONTROL_POINT_DEFAULT_VALUE;
+			ctrCnf.minControlPoint = ControllerConfig::MIN_CONTROL_POINT_DEFAULT_VALUE;
+			ctrCnf.maxControlPoint = ControllerConfig::MAX_CONTROL_POINT_DEFAULT_VALUE;
+			ctrCnf.compileCurve();
+		}
+
+		try {
+			ctrCnf.createTemperatureFilter();
+		} catch( std::invalid_argument const& e ) {
+			LogStream& log( LogStream::get() );
+			log << LogBuffer::Severity::WARNING
+			    << "Invalid temperature filter of controller " << i
+			    << " (" << e.what() << "); filter disabled" << std::flush;
+			ctrCnf.temperatureFilter = TemperatureFilter::Mode::NONE;
+		}
+	}
+}
+
+/**
+ * Compiles the explicit control curve or, if none is given, the curve
+ * defined by the base, low and high control points.
+ *
+ * @throw std::invalid_argument if the curve cannot be compiled
+ */
+void RuntimeConfig::ControllerConfig::compileCurve() {
+	curve = FanCurve( controlCurvePoints.empty() ? getThreePointCurve() : controlCurvePoints );
+}
+
+/**
+ * Returns the curve which is equivalent to the base, low and high control
+ * points.
+ *
+ * Below the base temperature the fan is off, up to the low temperature
+ * the low PWM value applies and up to the high temperature the PWM value
+ * is interpolated.
+ * Note, the PWM value of the base control point is not part of the curve,
+ * but the minimum value to spin up the fan.
+ */
+FanCurve::ControlPointSeq RuntimeConfig::ControllerConfig::getThreePointCurve() const {
+	return FanCurve::ControlPointSeq( {
+		{ baseControlPoint.temp, minControlPoint.pwmValue },
+		minControlPoint,
+		maxControlPoint
+	} );
+}
+
+/**
+ * Parses a sequence of control points.
+ *
+ * The points are separated by white space or commas and each point
+ * consists of a temperature and a PWM value separated by a colon, e.g.
+ * `45000:57 60000:100 95000:255`.
+ *
+ * @throw std::invalid_argument if the value is malformed or a PWM value
+ * exceeds `PWMActuator::MAX_PWM_VALUE`
+ */
+FanCurve::ControlPointSeq RuntimeConfig::parseControlCurve( std::string const& value ) {
+	FanCurve::ControlPointSeq points;
+	std::string::size_type pos = 0;
+	for(;;) {
+		pos = value.find_first_not_of( " \t,", pos );
+		if( pos == std::string::npos ) break;
+		std::string::size_type const end = value.find_first_of( " \t,", pos );
+		std::string const point( value.substr( pos, end == std::string::npos ? end : end - pos ) );
+		std::string::size_type const colon = point.find( ':' );
+		// `std::stoul` would accept a sign and wrap a negative number
+		if(
+			colon == std::string::npos || colon == 0 || colon + 1 == point.size() ||
+			!isDigit( point[0] ) ||
+			!isDigit( point[colon + 1] )
+		)
+			throw std::invalid_argument( "Malformed control point " + point );
+		std::size_t tempLength, pwmLength;
+		unsigned long const temp = std::stoul( point.substr( 0, colon ), &tempLength );
+		unsigned long const pwmValue = std::stoul( point.substr( colon + 1 ), &pwmLength );
+		if( tempLength != colon || pwmLength != point.size() - colon - 1 )
+			throw std::invalid_argument( "Malformed control point " + point );
+		if( pwmValue > PWMActuator::MAX_PWM_VALUE )
+			throw std::invalid_argument( "PWM value of control point " + point + " exceeds " + std::to_string( PWMActuator::MAX_PWM_VALUE ) );
+		points.push_back( { static_cast<Temperature>( temp ), static_cast<PwmValue>( pwmValue ) } );
+		pos = end;
+	}
+	if( points.empty() )
+		throw std::invalid_argument( "Empty control curve" );
+	return points;
+}
+
+/**
+ * Parses the control mode, either by name or by number.
+ *
+ * @throw std::invalid_argument if the value is neither
+ */
+RuntimeConfig::ControllerConfig::ControlMode RuntimeConfig::parseControlMode( std::string const& value ) {
+	if( value.compare("CURVE") == 0 || value.compare("0") == 0 )
+		return ControllerConfig::ControlMode::CURVE;
+	if( value.compare("PID") == 0 || value.compare("1") == 0 )
+		return ControllerConfig::ControlMode::PID;
+	throw std::invalid_argument( "Unknown control mode " + value );
+}
+
+/**
+ * Parses the backend of the temperature acquisition, either by name or by
+ * number.
+ *
+ * @throw std::invalid_argument if the value is neither
+ */
+TemperatureAcquisition::Backend RuntimeConfig::parseTemperatureAcquisition( std::string const& value ) {
+	if( value.compare("PREAD") == 0 || value.compare("0") == 0 )
+		return TemperatureAcquisition::Backend::PREAD;
+	if( value.compare("IO_URING") == 0 || value.compare("1") == 0 )
+		return TemperatureAcquisition::Backend::IO_URING;
+	throw std::invalid_argument( "Unknown temperature acquisition " + value );
+}
+
+/**
+ * Parses the mode of the temperature filter, either by name or by number.
+ *
+ * @throw std::invalid_argument if the value is neither
+ */
+TemperatureFilter::Mode RuntimeConfig::parseTemperatureFilter( std::string const& value ) {
+	if( value.compare("NONE") == 0 || value.compare("0") == 0 )
+		return TemperatureFilter::Mode::NONE;
+	if( value.compare("EMA") == 0 || value.compare("1") == 0 )
+		return TemperatureFilter::Mode::EMA;
+	if( value.compare("MEDIAN") == 0 || value.compare("2") == 0 )
+		return TemperatureFilter::Mode::MEDIAN;
+	if( value.compare("MEDIAN_EMA") == 0 || value.compare("3") == 0 )
+		return TemperatureFilter::Mode::MEDIAN_EMA;
+	throw std::invalid_argument( "Unknown temperature filter " + value );
+}
+
+/**
+ * Parses the aggregation of several temperature sensors, either by name
+ * or by number.
+ *
+ * @throw std::invalid_argument if the value is neither
+ */
+TemperatureInput::Aggregation RuntimeConfig::parseTemperatureAggregation( std::string const& value ) {
+	if( value.compare("MAX") == 0 || value.compare("0") == 0 )
+		return TemperatureInput::Aggregation::MAX;
+	if( value.compare("WEIGHTED") == 0 || value.compare("1") == 0 )
+		return TemperatureInput::Aggregation::WEIGHTED;
+	if( value.compare("MARGIN") == 0 || value.compare("2") == 0 )
+		return TemperatureInput::Aggregation::MARGIN;
+	throw std::invalid_argument( "Unknown temperature aggregation " + value );
+}
+
+/**
+ * Parses a non-empty list of unsigned integers separated by white space
+ * or commas.
+ *
+ * @throw std::invalid_argument if the value is malformed
+ */
+std::vector<unsigned long> RuntimeConfig::parseList( std::string const& value ) {
+	std::vector<unsigned long> list;
+	std::string::size_type pos = 0;
+	for(;;) {
+		pos = value.find_first_not_of( " \t,", pos );
+		if( pos == std::string::npos ) break;
+		std::string::size_type const end = value.find_first_of( " \t,", pos );
+		std::string const element( value.substr( pos, end == std::string::npos ? end : end - pos ) );
+		if( !isDigit( element[0] ) )
+			throw std::invalid_argument( "Malformed list element " + element );
+		std::size_t length;
+		unsigned long const number = std::stoul( element, &length );
+		if( length != element.size() )
+			throw std::invalid_argument( "Malformed list element " + element );
+		list.push_back( number );
+		pos = end;
+	}
+	if( list.empty() )
+		throw std::invalid_argument( "Empty list" );
+	return list;
+}
+
+/**
+ * Parses a non-negative gain of the PID mode.
+ *
+ * @throw std::invalid_argument if the value is malformed or negative
+ */
+double RuntimeConfig::parseGain( std::string const& value ) {
+	double const gain = std::stod( value );
+	if( !( gain >= 0.0 ) )
+		throw std::invalid_argument( "Negative gain" );
+	return gain;
+}
+
+/**
+ * Parses the log threshold, either by name or by its syslog level.
+ *
+ * @throw std::invalid_argument if the value is neither
+ */
+LogBuffer::Severity RuntimeConfig::parseLogTreshold( std::string const& value ) {
 	if( value.compare("EMERGENCY") == 0 || value.compare("0") == 0 )
-		log.setTreshold( LogBuffer::Severity::EMERGENCY );
-	else if( value.compare("ALERT") == 0 || value.compare("1") == 0 )
-		log.setTreshold( LogBuffer::Severity::ALERT );
-	else if( value.compare("CRITICAL") == 0 || value.compare("2") == 0 )
-		log.setTreshold( LogBuffer::Severity::CRITICAL );
-	else if( value.compare("ERROR") == 0 || value.compare("3") == 0 )
-		log.setTreshold( LogBuffer::Severity::ERROR );
-	else if( value.compare("WARNING") == 0 || value.compare("4") == 0 )
-		log.setTreshold( LogBuffer::Severity::WARNING );
-	else if( value.compare("NOTICE") == 0 || value.compare("5") == 0 )
-		log.setTreshold( LogBuffer::Severity::NOTICE );
-	else if( value.compare("INFO") == 0 || value.compare("6") == 0 )
-		log.setTreshold( LogBuffer::Severity::INFO );
-	else if( value.compare("DEBUG") == 0 || value.compare("7") == 0 )
-		log.setTreshold( LogBuffer::Severity::DEBUG );
-	else
-		log << LogBuffer::Severity::WARNING << "Invalid log level" << std::flush;
+		return LogBuffer::Severity::EMERGENCY;
+	if( value.compare("ALERT") == 0 || value.compare("1") == 0 )
+		return LogBuffer::Severity::ALERT;
+	if( value.compare("CRITICAL") == 0 || value.compare("2") == 0 )
+		return LogBuffer::Severity::CRITICAL;
+	if( value.compare("ERROR") == 0 || value.compare("3") == 0 )
+		return LogBuffer::Severity::ERROR;
+	if( value.compare("WARNING") == 0 || value.compare("4") == 0 )
+		return LogBuffer::Severity::WARNING;
+	if( value.compare("NOTICE") == 0 || value.compare("5") == 0 )
+		return LogBuffer::Severity::NOTICE;
+	if( value.compare("INFO") == 0 || value.compare("6") == 0 )
+		return LogBuffer::Severity::INFO;
+	if( value.compare("DEBUG") == 0 || value.compare("7") == 0 )
+		return LogBuffer::Severity::DEBUG;
+	throw std::invalid_argument( "Unknown log threshold " + value );
 }
 
 void RuntimeConfig::logConfiguration() const {
@@ -217,6 +1022,44 @@ void RuntimeConfig::logConfiguration() const {
 	log << CONTROL_INTERVAL_ATTRIBUTE
 	    << " = "
 	    << controlInterval.count() << std::flush;
+	log << MAX_CONTROL_INTERVAL_ATTRIBUTE
+	    << " = "
+	    << maxControlInterval.count() << std::flush;
+	log << TEMPERATURE_ALARM_WAKEUP_ATTRIBUTE
+	    << " = "
+	    << temperatureAlarmWakeup << std::flush;
+	log << TEMPERATURE_ACQUISITION_ATTRIBUTE
+	    << " = "
+	    << TemperatureAcquisition::getBackendName( temperatureAcquisition ) << std::flush;
+	log << TELEMETRY_FILE_PATH_ATTRIBUTE
+	    << " = "
+	    << telemetryFilePath << std::flush;
+	log << TELEMETRY_RECORD_COUNT_ATTRIBUTE
+	    << " = "
+	    << telemetryRecordCount << std::flush;
+	log << METRICS_SOCKET_PATH_ATTRIBUTE
+	    << " = "
+	    << metricsSocketPath << std::flush;
+	log << HWMON_CACHE_FILE_PATH_ATTRIBUTE
+	    << " = "
+	    << hwmonCacheFilePath << std::flush;
+	log << CONFIG_FILE_WATCH_ATTRIBUTE
+	    << " = "
+	    << configFileWatch << std::flush;
+	log << ADMIN_SOCKET_PATH_ATTRIBUTE
+	    << " = "
+	    << adminSocketPath << std::flush;
+	log << MAX_PWM_OVERRIDE_DURATION_ATTRIBUTE
+	    << " = "
+	    << maxPwmOverrideDuration.count() << std::flush;
+	log << REALTIME_PRIORITY_ATTRIBUTE
+	    << " = "
+	    << realtimePriority << std::flush;
+	log << CPU_AFFINITY_ATTRIBUTE
+	    << " =";
+	for( unsigned long const cpu : cpuAffinity )
+		log << " " << cpu;
+	std::flush( log );
 	for(TemperatureSensorIdx i = 0; i != temperatureSensorPaths.size(); i++) {
 		log << TEMPERATURE_SENSOR_PATH_ATTRIBUTE << "." << i
 		    << " = "
@@ -230,8 +1073,25 @@ void RuntimeConfig::logConfiguration() const {
 	for(ControllerConfigIdx i = 0; i != controllerConfigs.size(); i++) {
 		ControllerConfig const& ctrCnf(controllerConfigs[i]);
 		log << ControllerConfig::TEMPERATURE_SENSOR_INDEX_ATTRIBUTE << "." << i
-		    << " = "
-		    << ctrCnf.temperatureSensorIdx << std::flush;
+		    << " =";
+		for( TemperatureSensorIdx const sensorIdx : ctrCnf.temperatureSensorIndices )
+			log << " " << sensorIdx;
+		std::flush( log );
+		if( ctrCnf.temperatureSensorIndices.size() > 1 ) {
+			log << ControllerConfig::TEMPERATURE_AGGREGATION_ATTRIBUTE << "." << i
+			    << " = "
+			    << ctrCnf.temperatureAggregation << std::flush;
+			log << ControllerConfig::TEMPERATURE_SENSOR_WEIGHTS_ATTRIBUTE << "." << i
+			    << " =";
+			for( unsigned long const weight : ctrCnf.temperatureSensorWeights )
+				log << " " << weight;
+			std::flush( log );
+			log << ControllerConfig::TEMPERATURE_SENSOR_LIMITS_ATTRIBUTE << "." << i
+			    << " =";
+			for( Temperature const limit : ctrCnf.temperatureSensorLimits )
+				log << " " << limit;
+			std::flush( log );
+		}
 		log << ControllerConfig::PWM_ACTUATOR_INDEX_ATTRIBUTE << "." << i
 		    << " = "
 		    << ctrCnf.pwmActuatorIdx << std::flush;
@@ -259,6 +1119,42 @@ void RuntimeConfig::logConfiguration() const {
 		log << ControllerConfig::MAX_CONTROL_PWM_ATTRIBUTE << "." << i
 		    << " = "
 		    << ctrCnf.maxControlPoint.pwmValue << std::flush;
+		log << ControllerConfig::CONTROL_CURVE_ATTRIBUTE << "." << i
+		    << " =";
+		for( ControlPoint const& cp : ctrCnf.curve.getControlPoints() )
+			log << " " << cp.temp << ":" << cp.pwmValue;
+		std::flush( log );
+		log << ControllerConfig::CONTROL_MODE_ATTRIBUTE << "." << i
+		    << " = "
+		    << ( ctrCnf.controlMode == ControllerConfig::ControlMode::PID ? "PID" : "CURVE" ) << std::flush;
+		log << ControllerConfig::TEMPERATURE_FILTER_ATTRIBUTE << "." << i
+		    << " = "
+		    << ctrCnf.temperatureFilter << std::flush;
+		log << ControllerConfig::TEMPERATURE_FILTER_WINDOW_ATTRIBUTE << "." << i
+		    << " = "
+		    << ctrCnf.temperatureFilterWindow << std::flush;
+		log << ControllerConfig::TEMPERATURE_FILTER_EMA_SHIFT_ATTRIBUTE << "." << i
+		    << " = "
+		    << ctrCnf.temperatureFilterEmaShift << std::flush;
+		if( ctrCnf.controlMode != ControllerConfig::ControlMode::PID ) continue;
+		log << ControllerConfig::PID_TARGET_TEMPERATURE_ATTRIBUTE << "." << i
+		    << " = "
+		    << ctrCnf.pidTargetTemperature << std::flush;
+		log << ControllerConfig::PID_PROPORTIONAL_GAIN_ATTRIBUTE << "." << i
+		    << " = "
+		    << ctrCnf.pidProportionalGain << std::flush;
+		log << ControllerConfig::PID_INTEGRAL_GAIN_ATTRIBUTE << "." << i
+		    << " = "
+		    << ctrCnf.pidIntegralGain << std::flush;
+		log << ControllerConfig::PID_DERIVATIVE_GAIN_ATTRIBUTE << "." << i
+		    << " = "
+		    << ctrCnf.pidDerivativeGain << std::flush;
+		log << ControllerConfig::PID_SLEW_RATE_ATTRIBUTE << "." << i
+		    << " = "
+		    << ctrCnf.pidSlewRate << std::flush;
+		log << ControllerConfig::PID_OUTPUT_HYSTERESIS_ATTRIBUTE << "." << i
+		    << " = "
+		    << ctrCnf.pidOutputHysteresis << std::flush;
 	}
 }
 
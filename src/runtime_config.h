@@ -1,9 +1,17 @@
 #ifndef _RUNTIME_CONFIG_H_
 #define _RUNTIME_CONFIG_H_
 
+#include <istream>
+#include <limits>
+#include <memory>
 #include <string>
 #include <vector>
 #include "types.h"
+#include "logger2.h"
+#include "fan_curve.h"
+#include "temp_filter.h"
+#include "temp_input.h"
+#include "temp_acquisition.h"
 
 namespace AmdGpuFanControl {
 
@@ -12,18 +20,71 @@ class RuntimeConfig {
 		// General global settings which should only appear once
 		static char const* const SYSTEM_CONFIG_FILE_PATH;
 		static char const* const USER_CONFIG_FILE_PATH;
+		// The log settings take effect once the snapshot has been activated,
+		// see `PWMControllers`; a threshold given on the command line takes
+		// precedence, see `overrideLogTreshold`
 		static char const* const LOG_TRESHOLD_ATTRIBUTE;
+		static LogBuffer::Severity const LOG_TRESHOLD_DEFAULT_VALUE;
+		static char const* const LOG_ASYNCHRONOUS_ATTRIBUTE;
+		static bool const        LOG_ASYNCHRONOUS_DEFAULT_VALUE;
 		static char const* const CONTROL_INTERVAL_ATTRIBUTE;
 		static Duration const    CONTROL_INTERVAL_DEFAULT_VALUE;
+		// If larger than `CONTROL_INTERVAL`, the control interval adapts itself
+		// between both values; `CONTROL_INTERVAL` becomes the minimum
+		static char const* const MAX_CONTROL_INTERVAL_ATTRIBUTE;
+		static Duration const    MAX_CONTROL_INTERVAL_DEFAULT_VALUE;
+		// Whether alarm attributes of the temperature sensors shall wake up the
+		// control loop immediately
+		static char const* const TEMPERATURE_ALARM_WAKEUP_ATTRIBUTE;
+		static bool const        TEMPERATURE_ALARM_WAKEUP_DEFAULT_VALUE;
+		// How the temperature sensors are read, see `TemperatureAcquisition`
+		static char const* const TEMPERATURE_ACQUISITION_ATTRIBUTE;
+		static TemperatureAcquisition::Backend const TEMPERATURE_ACQUISITION_DEFAULT_VALUE;
+		// Binary telemetry ring; disabled if the path is empty
+		static char const* const TELEMETRY_FILE_PATH_ATTRIBUTE;
+		static char const* const TELEMETRY_FILE_PATH_DEFAULT_VALUE;
+		static char const* const TELEMETRY_RECORD_COUNT_ATTRIBUTE;
+		static unsigned long const TELEMETRY_RECORD_COUNT_DEFAULT_VALUE;
+		// Unix socket of the metrics exporter; disabled if the path is empty
+		static char const* const METRICS_SOCKET_PATH_ATTRIBUTE;
+		static char const* const METRICS_SOCKET_PATH_DEFAULT_VALUE;
+		// Cache of the resolved `hwmon://` references, see `HwmonResolver`
+		static char const* const HWMON_CACHE_FILE_PATH_ATTRIBUTE;
+		static char const* const HWMON_CACHE_FILE_PATH_DEFAULT_VALUE;
+		// Whether a change of the configuration file shall reload the
+		// configuration like `SIGHUP`
+		static char const* const CONFIG_FILE_WATCH_ATTRIBUTE;
+		static bool const        CONFIG_FILE_WATCH_DEFAULT_VALUE;
+		// Unix socket of the administration interface, see `AdminServer`;
+		// disabled if the path is empty
+		static char const* const ADMIN_SOCKET_PATH_ATTRIBUTE;
+		static char const* const ADMIN_SOCKET_PATH_DEFAULT_VALUE;
+		// Upper bound of the duration of a PWM override via the
+		// administration interface
+		static char const* const MAX_PWM_OVERRIDE_DURATION_ATTRIBUTE;
+		static Duration const    MAX_PWM_OVERRIDE_DURATION_DEFAULT_VALUE;
+		// `SCHED_FIFO` priority of the control thread, see `RealtimeMode`;
+		// disabled if zero
+		static char const* const REALTIME_PRIORITY_ATTRIBUTE;
+		static int const         REALTIME_PRIORITY_DEFAULT_VALUE;
+		// CPUs the control thread is pinned to; not pinned if empty
+		static char const* const CPU_AFFINITY_ATTRIBUTE;
 		// Settings which define sensor/actuators and should be iterated with a
-		// suffix ".<number>" for each sensor/actuator
+		// suffix ".<number>" for each sensor/actuator; a path may refer to a
+		// hwmon device by its identity as `hwmon://<identity>/<attribute>`
 		static char const* const TEMPERATURE_SENSOR_PATH_ATTRIBUTE;
 		static char const* const PWM_ACTUATOR_PATH_ATTRIBUTE;
+		// Upper bound for the suffix ".<number>" to guard against typos which
+		// would otherwise allocate huge sequences
+		static std::size_t const MAX_INDEX;
+		static std::size_t const UNDEFINED_INDEX;
 
 	public:
 		typedef std::vector<std::string> TemperatureSensorPathSeq;
 		typedef TemperatureSensorPathSeq::size_type TemperatureSensorIdx;
+		typedef std::vector<TemperatureSensorIdx> TemperatureSensorIdxSeq;
 		typedef std::vector<std::string> PwmActuatorPathSeq;
+		typedef std::vector<unsigned long> CpuSeq;
 		typedef PwmActuatorPathSeq::size_type PwmActuatorIdx;
 
 		class ControllerConfig {
@@ -32,7 +93,16 @@ class RuntimeConfig {
 			public:
 				// Settings which define a controller ans should be iterated with a
 				// suffix ".<number>" for each controller
+				// One index or a list of indices "<idx> ..." whose temperatures are
+				// aggregated, see `TemperatureInput`
 				static char const* const  TEMPERATURE_SENSOR_INDEX_ATTRIBUTE;
+				static char const* const  TEMPERATURE_AGGREGATION_ATTRIBUTE;
+				static TemperatureInput::Aggregation const TEMPERATURE_AGGREGATION_DEFAULT_VALUE;
+				// Lists with one element per sensor index; by default, the weights
+				// are equal and the limits are the critical temperatures of the
+				// sensors
+				static char const* const  TEMPERATURE_SENSOR_WEIGHTS_ATTRIBUTE;
+				static char const* const  TEMPERATURE_SENSOR_LIMITS_ATTRIBUTE;
 				static char const* const  PWM_ACTUATOR_INDEX_ATTRIBUTE;
 				static char const* const  UPWARD_TEMPERATURE_HYSTERESIS_ATTRIBUTE;
 				static Temperature const  UPWARD_TEMPERATURE_HYSTERESIS_DEFAULT_VALUE;
@@ -47,11 +117,54 @@ class RuntimeConfig {
 				static char const* const  MAX_CONTROL_TEMPERATURE_ATTRIBUTE;
 				static char const* const  MAX_CONTROL_PWM_ATTRIBUTE;
 				static ControlPoint const MAX_CONTROL_POINT_DEFAULT_VALUE;
+				// Arbitrary number of control points "<temp>:<pwm> ..."; if given,
+				// the curve supersedes the low and high control points
+				static char const* const  CONTROL_CURVE_ATTRIBUTE;
+
+				/**
+				 * `CURVE` sets the PWM value of the fan curve (subject to the
+				 * temperature hysteresis), `PID` drives the temperature towards
+				 * the target temperature with the fan curve as feed-forward.
+				 */
+				enum ControlMode : unsigned short {
+					CURVE = 0,
+					PID = 1
+				};
+				static char const* const  CONTROL_MODE_ATTRIBUTE;
+				static ControlMode const  CONTROL_MODE_DEFAULT_VALUE;
+				// Settings of the PID mode; gains are given in PWM values per K of
+				// the temperature error, per K·s of its integral and per K/s of its
+				// derivative, respectively
+				static char const* const  PID_TARGET_TEMPERATURE_ATTRIBUTE;
+				static Temperature const  PID_TARGET_TEMPERATURE_DEFAULT_VALUE;
+				static char const* const  PID_PROPORTIONAL_GAIN_ATTRIBUTE;
+				static double const       PID_PROPORTIONAL_GAIN_DEFAULT_VALUE;
+				static char const* const  PID_INTEGRAL_GAIN_ATTRIBUTE;
+				static double const       PID_INTEGRAL_GAIN_DEFAULT_VALUE;
+				static char const* const  PID_DERIVATIVE_GAIN_ATTRIBUTE;
+				static double const       PID_DERIVATIVE_GAIN_DEFAULT_VALUE;
+				// Maximum change of the PWM value per second
+				static char const* const  PID_SLEW_RATE_ATTRIBUTE;
+				static PwmValue const     PID_SLEW_RATE_DEFAULT_VALUE;
+				// Minimum change of the PWM value which is written, such that the
+				// fan does not toggle between adjacent PWM values
+				static char const* const  PID_OUTPUT_HYSTERESIS_ATTRIBUTE;
+				static PwmValue const     PID_OUTPUT_HYSTERESIS_DEFAULT_VALUE;
+				// Noise filter of the temperature, see `TemperatureFilter`
+				static char const* const  TEMPERATURE_FILTER_ATTRIBUTE;
+				static TemperatureFilter::Mode const TEMPERATURE_FILTER_DEFAULT_VALUE;
+				static char const* const  TEMPERATURE_FILTER_WINDOW_ATTRIBUTE;
+				static unsigned const     TEMPERATURE_FILTER_WINDOW_DEFAULT_VALUE;
+				static char const* const  TEMPERATURE_FILTER_EMA_SHIFT_ATTRIBUTE;
+				static unsigned const     TEMPERATURE_FILTER_EMA_SHIFT_DEFAULT_VALUE;
 
 			public:
 				ControllerConfig() :
-					temperatureSensorIdx(-1),
-					pwmActuatorIdx(-1),
+					temperatureSensorIndices(),
+					temperatureAggregation(TEMPERATURE_AGGREGATION_DEFAULT_VALUE),
+					temperatureSensorWeights(),
+					temperatureSensorLimits(),
+					pwmActuatorIdx(UNDEFINED_INDEX),
 					upwardTemperatureHysteresis(
 						UPWARD_TEMPERATURE_HYSTERESIS_DEFAULT_VALUE
 					),
@@ -60,19 +173,57 @@ class RuntimeConfig {
 					),
 					baseControlPoint(BASE_CONTROL_POINT_DEFAULT_VALUE),
 					minControlPoint(MIN_CONTROL_POINT_DEFAULT_VALUE),
-					maxControlPoint(MAX_CONTROL_POINT_DEFAULT_VALUE) {};
+					maxControlPoint(MAX_CONTROL_POINT_DEFAULT_VALUE),
+					controlCurvePoints(),
+					curve(),
+					controlMode(CONTROL_MODE_DEFAULT_VALUE),
+					pidTargetTemperature(PID_TARGET_TEMPERATURE_DEFAULT_VALUE),
+					pidProportionalGain(PID_PROPORTIONAL_GAIN_DEFAULT_VALUE),
+					pidIntegralGain(PID_INTEGRAL_GAIN_DEFAULT_VALUE),
+					pidDerivativeGain(PID_DERIVATIVE_GAIN_DEFAULT_VALUE),
+					pidSlewRate(PID_SLEW_RATE_DEFAULT_VALUE),
+					pidOutputHysteresis(PID_OUTPUT_HYSTERESIS_DEFAULT_VALUE),
+					temperatureFilter(TEMPERATURE_FILTER_DEFAULT_VALUE),
+					temperatureFilterWindow(TEMPERATURE_FILTER_WINDOW_DEFAULT_VALUE),
+					temperatureFilterEmaShift(TEMPERATURE_FILTER_EMA_SHIFT_DEFAULT_VALUE) {
+					compileCurve();
+				};
 				ControllerConfig(ControllerConfig const& other) :
-					temperatureSensorIdx(other.temperatureSensorIdx),
+					temperatureSensorIndices(other.temperatureSensorIndices),
+					temperatureAggregation(other.temperatureAggregation),
+					temperatureSensorWeights(other.temperatureSensorWeights),
+					temperatureSensorLimits(other.temperatureSensorLimits),
 					pwmActuatorIdx(other.pwmActuatorIdx),
 					upwardTemperatureHysteresis(other.upwardTemperatureHysteresis),
 					downwardTemperatureHysteresis(other.downwardTemperatureHysteresis),
 					baseControlPoint(other.baseControlPoint),
 					minControlPoint(other.minControlPoint),
-					maxControlPoint(other.maxControlPoint) {};
-				TemperatureSensorPathIdx getTemperatureSensorIdx() const {
-					return temperatureSensorIdx;
+					maxControlPoint(other.maxControlPoint),
+					controlCurvePoints(other.controlCurvePoints),
+					curve(other.curve),
+					controlMode(other.controlMode),
+					pidTargetTemperature(other.pidTargetTemperature),
+					pidProportionalGain(other.pidProportionalGain),
+					pidIntegralGain(other.pidIntegralGain),
+					pidDerivativeGain(other.pidDerivativeGain),
+					pidSlewRate(other.pidSlewRate),
+					pidOutputHysteresis(other.pidOutputHysteresis),
+					temperatureFilter(other.temperatureFilter),
+					temperatureFilterWindow(other.temperatureFilterWindow),
+					temperatureFilterEmaShift(other.temperatureFilterEmaShift) {};
+				TemperatureSensorIdxSeq const& getTemperatureSensorIdxSeq() const {
+					return temperatureSensorIndices;
+				};
+				TemperatureInput::Aggregation getTemperatureAggregation() const {
+					return temperatureAggregation;
 				};
-				PwmActuatorPathIdx getPwmActuatorIdx() const {
+				TemperatureInput::WeightSeq const& getTemperatureSensorWeights() const {
+					return temperatureSensorWeights;
+				};
+				TemperatureInput::LimitSeq const& getTemperatureSensorLimits() const {
+					return temperatureSensorLimits;
+				};
+				PwmActuatorIdx getPwmActuatorIdx() const {
 					return pwmActuatorIdx;
 				};
 				Temperature getUpwardTemperatureHysteresis() const {
@@ -90,10 +241,50 @@ class RuntimeConfig {
 				ControlPoint const& getHighControlPoint() const {
 					return maxControlPoint;
 				};
+				/**
+				 * Returns the compiled fan curve.
+				 *
+				 * Unless the configuration defines an explicit curve, the curve
+				 * consists of the points (base temperature, low PWM value),
+				 * (low temperature, low PWM value) and (high temperature, high PWM
+				 * value).
+				 */
+				FanCurve const& getCurve() const {
+					return curve;
+				};
+				ControlMode getControlMode() const {
+					return controlMode;
+				};
+				Temperature getPidTargetTemperature() const {
+					return pidTargetTemperature;
+				};
+				double getPidProportionalGain() const {
+					return pidProportionalGain;
+				};
+				double getPidIntegralGain() const {
+					return pidIntegralGain;
+				};
+				double getPidDerivativeGain() const {
+					return pidDerivativeGain;
+				};
+				PwmValue getPidSlewRate() const {
+					return pidSlewRate;
+				};
+				PwmValue getPidOutputHysteresis() const {
+					return pidOutputHysteresis;
+				};
+				/**
+				 * Creates a new filter with the configured settings.
+				 */
+				TemperatureFilter createTemperatureFilter() const {
+					return TemperatureFilter(
+						temperatureFilter, temperatureFilterWindow, temperatureFilterEmaShift
+					);
+				};
 
 			protected:
-				void setTemperatureSensorIdx(TemperatureSensorIdx idx) {
-					temperatureSensorIdx = idx;
+				void setTemperatureSensorIdxSeq(TemperatureSensorIdxSeq const& indices) {
+					temperatureSensorIndices = indices;
 				};
 				void setPwmActuatorIdx(PwmActuatorIdx idx) {
 					pwmActuatorIdx = idx;
@@ -113,20 +304,50 @@ class RuntimeConfig {
 				void setHighControlPoint(ControlPoint const& cp) {
 					maxControlPoint = cp;
 				};
+				void compileCurve();
+				FanCurve::ControlPointSeq getThreePointCurve() const;
 
 			private:
-				TemperatureSensorIdx temperatureSensorIdx;
+				TemperatureSensorIdxSeq temperatureSensorIndices;
+				TemperatureInput::Aggregation temperatureAggregation;
+				TemperatureInput::WeightSeq temperatureSensorWeights;
+				TemperatureInput::LimitSeq temperatureSensorLimits;
 				PwmActuatorIdx pwmActuatorIdx;
 				Temperature upwardTemperatureHysteresis;
 				Temperature downwardTemperatureHysteresis;
 				ControlPoint baseControlPoint;
 				ControlPoint minControlPoint;
 				ControlPoint maxControlPoint;
+				FanCurve::ControlPointSeq controlCurvePoints;
+				FanCurve curve;
+				ControlMode controlMode;
+				Temperature pidTargetTemperature;
+				double pidProportionalGain;
+				double pidIntegralGain;
+				double pidDerivativeGain;
+				PwmValue pidSlewRate;
+				PwmValue pidOutputHysteresis;
+				TemperatureFilter::Mode temperatureFilter;
+				unsigned temperatureFilterWindow;
+				unsigned temperatureFilterEmaShift;
 		};
 
 		typedef std::vector<ControllerConfig> ControllerConfigSeq;
 		typedef ControllerConfigSeq::size_type ControllerConfigIdx;
 
+		/**
+		 * A single line of the configuration.
+		 *
+		 * The grammar of a line is `ATTRIBUTE[.index] = value` where the
+		 * attribute consists of letters and underscores, the optional index
+		 * of decimal digits and the value of any characters; white space is
+		 * allowed around the equal sign and at both ends of the line, but
+		 * white space inside the value is preserved.
+		 * Empty lines and lines whose first non-blank character is `#` are
+		 * ignored.
+		 * The line is lexed in a single pass; upon a syntax error, the
+		 * column of the offending character is reported.
+		 */
 		class ConfigLine {
 			public:
 				ConfigLine(std::string const& line);
@@ -134,20 +355,34 @@ class RuntimeConfig {
 					attribute(other.attribute),
 					index(other.index),
 					value(other.value),
-					valid(false),
-					failed(false) {};
+					valid(other.valid),
+					failed(other.failed),
+					errorColumn(other.errorColumn),
+					errorMessage(other.errorMessage) {};
 				ConfigLine(ConfigLine&& other) :
 					attribute(std::move(other.attribute)),
 					index(other.index),
 					value(std::move(other.value)),
 					valid(other.valid),
-					failed(other.failed) {
+					failed(other.failed),
+					errorColumn(other.errorColumn),
+					errorMessage(other.errorMessage) {
 					other.valid = false;
 				};
 				std::string const& getAttribute() const { return attribute; };
+				/**
+				 * Returns the index; an index which exceeds `MAX_INDEX` is
+				 * saturated, i.e. any index larger than `MAX_INDEX` is reported
+				 * as `MAX_INDEX + 1`.
+				 */
 				size_t getIndex() const { return index; };
+				/**
+				 * Indicates whether the attribute has an explicit suffix
+				 * ".<number>".
+				 */
+				bool hasIndex() const { return index != UNDEFINED_INDEX; };
 				std::string const& getValue() const { return value; };
-				unsigned long getValueAsUL() const { return std::stoul(value); }
+				unsigned long getValueAsUL( unsigned long const max = std::numeric_limits<unsigned long>::max() ) const;
 				/**
 				 * Indicates whether the associated line has successfully been parsed
 				 * as a proper configuration line with an (attribute,value)-pair.
@@ -166,6 +401,19 @@ class RuntimeConfig {
 				 * at the same time, i.e. if the line is empty or a comment.
 				 */
 				bool hasFailed() const { return failed; };
+				/**
+				 * Returns the column (starting at 1) at which the syntax error
+				 * has been detected or 0 if the line has not failed.
+				 */
+				std::size_t getErrorColumn() const { return errorColumn; };
+				/**
+				 * Returns a description of the syntax error or `nullptr` if the
+				 * line has not failed.
+				 */
+				char const* getErrorMessage() const { return errorMessage; };
+
+			private:
+				void fail(std::string::size_type const pos, char const* const message);
 
 			private:
 				std::string attribute;
@@ -173,36 +421,114 @@ class RuntimeConfig {
 				std::string value;
 				bool valid;
 				bool failed;
+				std::size_t errorColumn;
+				char const* errorMessage;
 		};
-	private:
+	public:
+		/**
+		 * An immutable snapshot of the configuration.
+		 */
+		typedef std::shared_ptr<RuntimeConfig const> Ptr;
+
+	public:
 		RuntimeConfig();
-		RuntimeConfig( RuntimeConfig const& ) = delete;
 		RuntimeConfig& operator=( RuntimeConfig const& ) = delete;
 
+	private:
+		/**
+		 * Only used to derive a modified snapshot, see `withControlCurve`.
+		 */
+		RuntimeConfig( RuntimeConfig const& ) = default;
+
 	public:
-		static RuntimeConfig& get();
+		static Ptr load();
+		static Ptr load( std::string const& filePath );
+		static Ptr getCurrent();
+		static void publish( Ptr const& config );
+		static void overrideLogTreshold( LogBuffer::Severity const treshold );
 		void loadDefaults();
 		void loadFromFile();
+		void loadFromFile( std::string const& filePath );
+		void loadFromStream( std::istream& configFileStream );
 		void logConfiguration() const;
+		Ptr withControlCurve( ControllerConfigIdx const idx, std::string const& value ) const;
+		LogBuffer::Severity getLogTreshold() const {
+			return isLogTresholdOverridden ? logTresholdOverride : logTreshold;
+		};
+		bool isLogAsynchronous() const { return logAsynchronous; };
 		Duration getControlInterval() const { return controlInterval; };
-		PwmActuatorPathSeq const& getTemperatureSensorPathSeq() const {
+		Duration getMaxControlInterval() const { return maxControlInterval; };
+		bool isAdaptiveControlInterval() const {
+			return maxControlInterval > controlInterval;
+		};
+		bool isTemperatureAlarmWakeup() const { return temperatureAlarmWakeup; };
+		TemperatureAcquisition::Backend getTemperatureAcquisition() const { return temperatureAcquisition; };
+		std::string const& getTelemetryFilePath() const { return telemetryFilePath; };
+		unsigned long getTelemetryRecordCount() const { return telemetryRecordCount; };
+		std::string const& getMetricsSocketPath() const { return metricsSocketPath; };
+		std::string const& getHwmonCacheFilePath() const { return hwmonCacheFilePath; };
+		bool isConfigFileWatch() const { return configFileWatch; };
+		std::string const& getAdminSocketPath() const { return adminSocketPath; };
+		Duration getMaxPwmOverrideDuration() const { return maxPwmOverrideDuration; };
+		int getRealtimePriority() const { return realtimePriority; };
+		CpuSeq const& getCpuAffinity() const { return cpuAffinity; };
+		/**
+		 * Returns the path of the file the configuration has been loaded
+		 * from or an empty string if no file has been found.
+		 */
+		std::string const& getFilePath() const { return filePath; };
+		TemperatureSensorPathSeq const& getTemperatureSensorPathSeq() const {
 			return temperatureSensorPaths;
 		};
-		TemperatureSensorPathSeq const& getPwmActuatorPathSeq() const {
+		PwmActuatorPathSeq const& getPwmActuatorPathSeq() const {
 			return pwmActuatorPaths;
 		};
 		ControllerConfigSeq const& getControllerConfigSeq() const {
 			return controllerConfigs;
 		};
 
+		/**
+		 * Identifies an attribute; only defined in `runtime_config.cpp`.
+		 */
+		enum class Attribute : unsigned char;
+
 	private:
-		void loadLogTreshold( std::string const& value );
+		void loadAttribute( Attribute const attribute, ConfigLine const& configLine );
+		void loadControllerAttribute( Attribute const attribute, ConfigLine const& configLine );
+		ControllerConfig& provideControllerConfig( ControllerConfigIdx const idx );
+		void resolveControllerDefaults();
+		static FanCurve::ControlPointSeq parseControlCurve( std::string const& value );
+		static ControllerConfig::ControlMode parseControlMode( std::string const& value );
+		static TemperatureFilter::Mode parseTemperatureFilter( std::string const& value );
+		static TemperatureAcquisition::Backend parseTemperatureAcquisition( std::string const& value );
+		static LogBuffer::Severity parseLogTreshold( std::string const& value );
+		static TemperatureInput::Aggregation parseTemperatureAggregation( std::string const& value );
+		static std::vector<unsigned long> parseList( std::string const& value );
+		static double parseGain( std::string const& value );
 
 	private:
+		LogBuffer::Severity logTreshold;
+		bool logAsynchronous;
 		Duration controlInterval;
+		Duration maxControlInterval;
+		bool temperatureAlarmWakeup;
+		TemperatureAcquisition::Backend temperatureAcquisition;
+		std::string telemetryFilePath;
+		unsigned long telemetryRecordCount;
+		std::string metricsSocketPath;
+		std::string hwmonCacheFilePath;
+		bool configFileWatch;
+		std::string adminSocketPath;
+		Duration maxPwmOverrideDuration;
+		int realtimePriority;
+		CpuSeq cpuAffinity;
+		std::string filePath;
 		TemperatureSensorPathSeq temperatureSensorPaths;
 		PwmActuatorPathSeq pwmActuatorPaths;
 		ControllerConfigSeq controllerConfigs;
+		static Ptr current;
+		static LogBuffer::Severity logTresholdOverride;
+		static bool isLogTresholdOverridden;
 };
 
 }
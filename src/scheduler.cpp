@@ -0,0 +1,273 @@
+#include "scheduler.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <algorithm>
+#include <system_error>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+namespace AmdGpuFanControl {
+
+static timespec toTimespec( DeadlineScheduler::Nanoseconds const ns ) {
+	timespec ts;
+	ts.tv_sec = ns.count() / 1000000000;
+	ts.tv_nsec = ns.count() % 1000000000;
+	return ts;
+}
+
+DeadlineScheduler::DeadlineScheduler() :
+	fd( -1 ),
+	epollFd( -1 ),
+	notifyFd( -1 ),
+	readyFds(),
+	period( 0 ),
+	startTime(),
+	deadline(),
+	lastWakeup(),
+	ticks( 0 ),
+	overruns( 0 ),
+	skippedTicks( 0 ),
+	alarmWakeups( 0 ),
+	latencyHistogram(),
+	maxJitter( 0 ),
+	sumJitter( 0 ) {
+	epollFd = epoll_create1( EPOLL_CLOEXEC );
+	if( epollFd == -1 )
+		throw std::system_error( errno, std::generic_category(), "epoll_create1" );
+	fd = timerfd_create( CLOCK_MONOTONIC, TFD_CLOEXEC );
+	if( fd == -1 ) {
+		int const e = errno;
+		close( epollFd );
+		throw std::system_error( e, std::generic_category(), "timerfd_create" );
+	}
+	notifyFd = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+	if( notifyFd == -1 ) {
+		int const e = errno;
+		close( fd );
+		close( epollFd );
+		throw std::system_error( e, std::generic_category(), "eventfd" );
+	}
+	readyFds.reserve( MAX_EVENTS );
+	add( fd, Source::TIMER_SOURCE, EPOLLIN );
+	add( notifyFd, Source::NOTIFY_SOURCE, EPOLLIN );
+}
+
+DeadlineScheduler::~DeadlineScheduler() {
+	close( notifyFd );
+	close( fd );
+	close( epollFd );
+}
+
+/**
+ * Adds a file descriptor to the `epoll` wait set.
+ *
+ * @return `false` if the file does not support polling (e.g. a regular
+ * file instead of a sysfs attribute)
+ */
+bool DeadlineScheduler::add( int const f, Source const source, std::uint32_t const events ) {
+	epoll_event event;
+	event.events = events;
+	event.data.u64 = static_cast<std::uint64_t>( source ) << 32 | static_cast<std::uint32_t>( f );
+	if( epoll_ctl( epollFd, EPOLL_CTL_ADD, f, &event ) == -1 ) {
+		if( errno == EPERM ) return false;
+		throw std::system_error( errno, std::generic_category(), "epoll_ctl" );
+	}
+	return true;
+}
+
+/**
+ * Arms the timer such that the first tick happens one period from now.
+ *
+ * @internal `steady_clock` is based on `CLOCK_MONOTONIC` on Linux, hence
+ * its time points can directly be used as absolute deadlines of the timer.
+ */
+void DeadlineScheduler::start( Duration const p ) {
+	period = p;
+	startTime = lastWakeup = Clock::now();
+	deadline = lastWakeup + period;
+	arm();
+}
+
+/**
+ * Changes the period of a running scheduler.
+ *
+ * The next deadline is re-computed relative to the most recent deadline,
+ * i.e. the phase of the schedule is kept.
+ * If the new next deadline has already passed (because the period has been
+ * shortened), the next tick happens immediately.
+ */
+void DeadlineScheduler::setPeriod( Duration const p ) {
+	if( p == period ) return;
+	deadline += p - period;
+	period = p;
+	arm();
+}
+
+void DeadlineScheduler::arm() {
+	itimerspec spec;
+	spec.it_value = toTimespec( deadline.time_since_epoch() );
+	spec.it_interval = toTimespec( period );
+	if( timerfd_settime( fd, TFD_TIMER_ABSTIME, &spec, nullptr ) == -1 )
+		throw std::system_error( errno, std::generic_category(), "timerfd_settime" );
+}
+
+/**
+ * Adds a sysfs attribute to the wait set.
+ *
+ * The attribute must already have been read once, otherwise the kernel
+ * reports it as changed immediately.
+ *
+ * @return `false` if the file does not support polling and thus cannot
+ * end the wait
+ */
+bool DeadlineScheduler::addAlarmFd( int const alarmFd ) {
+	return add( alarmFd, Source::ALARM_SOURCE, EPOLLPRI | EPOLLERR );
+}
+
+/**
+ * Adds a file descriptor to the wait set which ends the wait if it becomes
+ * readable.
+ *
+ * The caller must consume the data, otherwise the next wait ends
+ * immediately again.
+ */
+void DeadlineScheduler::addEventFd( int const eventFd ) {
+	add( eventFd, Source::EVENT_SOURCE, EPOLLIN );
+}
+
+/**
+ * Removes an alarm attribute or an event file descriptor from the wait
+ * set; must be called before the file descriptor is closed.
+ */
+void DeadlineScheduler::removeFd( int const f ) {
+	epoll_ctl( epollFd, EPOLL_CTL_DEL, f, nullptr );
+	readyFds.erase( std::remove( readyFds.begin(), readyFds.end(), f ), readyFds.end() );
+}
+
+/**
+ * Ends the current (or the next) wait early.
+ *
+ * The method is thread-safe and async-signal-safe.
+ */
+void DeadlineScheduler::notify() {
+	std::uint64_t const one = 1;
+	if( write( notifyFd, &one, sizeof( one ) ) != sizeof( one ) ) {
+		// Cannot happen for an eventfd unless the counter overflows
+	}
+}
+
+/**
+ * Blocks until the next tick, until an alarm attribute changes, until
+ * an event file descriptor becomes readable or until `notify` is called.
+ *
+ * @return `TICK` if a tick has happened, `ALARM` if an alarm attribute has
+ * changed before the next tick, `EVENT` if an event file descriptor has
+ * become readable before the next tick (see `isReady`), `INTERRUPTED` if
+ * the wait has been ended by `notify` or by a signal
+ */
+DeadlineScheduler::Wakeup DeadlineScheduler::wait() {
+	epoll_event events[MAX_EVENTS];
+	readyFds.clear();
+	int const n = epoll_wait( epollFd, events, MAX_EVENTS, -1 );
+	if( n == -1 ) {
+		if( errno == EINTR ) return Wakeup::INTERRUPTED;
+		throw std::system_error( errno, std::generic_category(), "epoll_wait" );
+	}
+	bool isTick = false;
+	bool isAlarm = false;
+	for( int i = 0; i != n; i++ ) {
+		int const f = static_cast<int>( events[i].data.u64 & 0xffffffff );
+		switch( static_cast<Source>( events[i].data.u64 >> 32 ) ) {
+			case Source::TIMER_SOURCE:
+				consumeTick();
+				isTick = true;
+				break;
+			case Source::NOTIFY_SOURCE: {
+				std::uint64_t count;
+				if( read( notifyFd, &count, sizeof( count ) ) != sizeof( count ) ) {
+					// Another wakeup has already consumed the notification
+				}
+				break;
+			}
+			case Source::ALARM_SOURCE:
+				acknowledgeAlarm( f );
+				isAlarm = true;
+				break;
+			case Source::EVENT_SOURCE:
+				readyFds.push_back( f );
+				break;
+		}
+	}
+	if( isTick ) return Wakeup::TICK;
+	if( isAlarm ) {
+		alarmWakeups++;
+		return Wakeup::ALARM;
+	}
+	if( !readyFds.empty() ) return Wakeup::EVENT;
+	return Wakeup::INTERRUPTED;
+}
+
+/**
+ * Returns whether an event file descriptor has become readable during the
+ * most recent wait, independent of what the wait has returned.
+ */
+bool DeadlineScheduler::isReady( int const eventFd ) const {
+	return std::find( readyFds.begin(), readyFds.end(), eventFd ) != readyFds.end();
+}
+
+void DeadlineScheduler::consumeTick() {
+	std::uint64_t expirations;
+	if( read( fd, &expirations, sizeof( expirations ) ) != sizeof( expirations ) )
+		throw std::system_error( errno, std::generic_category(), "read from timerfd" );
+	Clock::time_point const now = Clock::now();
+
+	// All expirations since the last wakeup are collapsed into this wakeup;
+	// `deadline` holds the next deadline, so afterwards it lies one period
+	// after the most recent expiration, which this wakeup is measured against
+	deadline += expirations * period;
+	ticks++;
+	if( expirations > 1 ) {
+		overruns++;
+		skippedTicks += expirations - 1;
+	}
+
+	Nanoseconds const latency( now - ( deadline - period ) );
+	Nanoseconds const actualPeriod( now - lastWakeup );
+	Nanoseconds const jitter( actualPeriod > expirations * period ?
+		actualPeriod - expirations * period :
+		expirations * period - actualPeriod
+	);
+	lastWakeup = now;
+	latencyHistogram.record( latency );
+	maxJitter = std::max( maxJitter, jitter );
+	sumJitter += jitter;
+}
+
+/**
+ * Re-reads an alarm attribute which has changed.
+ *
+ * Reading the attribute re-arms the notification.
+ */
+void DeadlineScheduler::acknowledgeAlarm( int const alarmFd ) {
+	char buffer[16];
+	if( pread( alarmFd, buffer, sizeof( buffer ), 0 ) == -1 ) {
+		// The next cycle reports the error when it reads the sensor
+	}
+}
+
+/**
+ * Returns the average number of wakeups per second since `start`.
+ */
+double DeadlineScheduler::getWakeupRate() const {
+	std::chrono::duration<double> const elapsed( Clock::now() - startTime );
+	return elapsed.count() == 0.0 ? 0.0 : ticks / elapsed.count();
+}
+
+DeadlineScheduler::Nanoseconds DeadlineScheduler::getMeanJitter() const {
+	return ticks == 0 ? Nanoseconds( 0 ) : sumJitter / static_cast<long>( ticks );
+}
+
+}
@@ -0,0 +1,126 @@
+#ifndef _SCHEDULER_H_
+#define _SCHEDULER_H_
+
+#include "types.h"
+#include "histogram.h"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace AmdGpuFanControl {
+
+/**
+ * Triggers the control cycle on absolute deadlines.
+ *
+ * Sleeping for the control interval after each cycle stretches the real
+ * period by the time the cycle itself takes and the error accumulates.
+ * Instead, this class arms a `timerfd` on `CLOCK_MONOTONIC` with absolute
+ * deadlines `start + k * period`, i.e. the period does not drift
+ * independent of how long a cycle takes.
+ *
+ * If a cycle overruns one or more deadlines, the missed ticks are not
+ * caught up (which would bunch several cycles together), but skipped.
+ * The class counts such overruns and the skipped ticks.
+ *
+ * The period may be changed while the scheduler is running, see
+ * `setPeriod`; this is used by the adaptive control interval.
+ *
+ * The timer is part of a single `epoll` wait set which is the only place
+ * where the control thread blocks.
+ * Additionally, sysfs alarm attributes can be added to the wait set, see
+ * `addAlarmFd`.
+ * A change of any of these attributes ends the wait immediately, i.e. the
+ * control cycle reacts to a crossed threshold without waiting for the next
+ * tick.
+ * Likewise, any other file descriptor which becomes readable (e.g. a
+ * `signalfd` or an inotify instance) ends the wait, see `addEventFd` and
+ * `isReady`, and so does `notify` which may be called from any thread.
+ * Such early wakeups do not affect the schedule of the ticks.
+ *
+ * For each wakeup the class measures
+ *  - the latency, i.e. how late the wakeup happened after its deadline, and
+ *  - the jitter, i.e. how much the period between two consecutive wakeups
+ *    deviates from the nominal period.
+ * The distribution of the latency is kept, as its maximum is the bound
+ * which `RealtimeMode` is meant to guarantee.
+ */
+class DeadlineScheduler {
+	public:
+		typedef std::chrono::steady_clock Clock;
+		typedef std::chrono::nanoseconds Nanoseconds;
+		typedef std::vector<int> FdCollection;
+
+		enum Wakeup : unsigned short {
+			INTERRUPTED = 0,
+			TICK = 1,
+			ALARM = 2,
+			EVENT = 3
+		};
+
+	public:
+		DeadlineScheduler();
+		DeadlineScheduler( DeadlineScheduler const& ) = delete;
+		DeadlineScheduler& operator=( DeadlineScheduler const& ) = delete;
+		~DeadlineScheduler();
+
+	public:
+		void start( Duration const p );
+		void setPeriod( Duration const p );
+		bool addAlarmFd( int const alarmFd );
+		void addEventFd( int const eventFd );
+		void removeFd( int const fd );
+		void notify();
+		Wakeup wait();
+		bool isReady( int const eventFd ) const;
+		Duration getPeriod() const { return period; };
+		double getWakeupRate() const;
+		unsigned long getTicks() const { return ticks; };
+		unsigned long getOverruns() const { return overruns; };
+		unsigned long getSkippedTicks() const { return skippedTicks; };
+		unsigned long getAlarmWakeups() const { return alarmWakeups; };
+		Nanoseconds getMaxLatency() const { return latencyHistogram.getMax(); };
+		LatencyHistogram const& getLatencyHistogram() const { return latencyHistogram; };
+		Nanoseconds getMaxJitter() const { return maxJitter; };
+		Nanoseconds getMeanJitter() const;
+
+	private:
+		/**
+		 * Kind of a file descriptor in the wait set; stored in the upper half
+		 * of the user data of its `epoll` entry.
+		 */
+		enum Source : std::uint32_t {
+			TIMER_SOURCE = 0,
+			NOTIFY_SOURCE = 1,
+			ALARM_SOURCE = 2,
+			EVENT_SOURCE = 3
+		};
+
+		static constexpr int MAX_EVENTS = 16;
+
+	private:
+		bool add( int const fd, Source const source, std::uint32_t const events );
+		void arm();
+		void consumeTick();
+		void acknowledgeAlarm( int const alarmFd );
+
+	private:
+		int fd;
+		int epollFd;
+		int notifyFd;
+		FdCollection readyFds;
+		Duration period;
+		Clock::time_point startTime;
+		Clock::time_point deadline;
+		Clock::time_point lastWakeup;
+		unsigned long ticks;
+		unsigned long overruns;
+		unsigned long skippedTicks;
+		unsigned long alarmWakeups;
+		LatencyHistogram latencyHistogram;
+		Nanoseconds maxJitter;
+		Nanoseconds sumJitter;
+};
+
+}
+
+#endif
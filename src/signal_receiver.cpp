@@ -0,0 +1,62 @@
+#include "signal_receiver.h"
+
+#include <cerrno>
+#include <system_error>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+namespace AmdGpuFanControl {
+
+SignalReceiver::SignalReceiver() :
+	fd( -1 ),
+	previousMask() {
+	sigemptyset( &previousMask );
+}
+
+SignalReceiver::~SignalReceiver() {
+	close();
+}
+
+/**
+ * Blocks the given signals on the calling thread and starts receiving
+ * them; any previous receiver is closed.
+ *
+ * @throw std::system_error if the `signalfd` cannot be created
+ */
+void SignalReceiver::open( std::initializer_list<int> const signals ) {
+	close();
+	sigset_t mask;
+	sigemptyset( &mask );
+	for( int const signal : signals ) sigaddset( &mask, signal );
+
+	pthread_sigmask( SIG_BLOCK, &mask, &previousMask );
+	fd = signalfd( -1, &mask, SFD_NONBLOCK | SFD_CLOEXEC );
+	if( fd == -1 ) {
+		int const e = errno;
+		pthread_sigmask( SIG_SETMASK, &previousMask, nullptr );
+		throw std::system_error( e, std::generic_category(), "signalfd" );
+	}
+}
+
+/**
+ * Stops receiving and restores the signal mask of the calling thread.
+ */
+void SignalReceiver::close() {
+	if( fd == -1 ) return;
+	::close( fd );
+	fd = -1;
+	pthread_sigmask( SIG_SETMASK, &previousMask, nullptr );
+}
+
+/**
+ * Dequeues the next pending signal.
+ *
+ * @return the signal number or `0` if no signal is pending
+ */
+int SignalReceiver::receive() {
+	signalfd_siginfo info;
+	if( fd == -1 || read( fd, &info, sizeof( info ) ) != sizeof( info ) ) return 0;
+	return static_cast<int>( info.ssi_signo );
+}
+
+}
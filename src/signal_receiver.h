@@ -0,0 +1,48 @@
+#ifndef _SIGNAL_RECEIVER_H_
+#define _SIGNAL_RECEIVER_H_
+
+#include <initializer_list>
+#include <signal.h>
+
+namespace AmdGpuFanControl {
+
+/**
+ * Receives signals synchronously via a `signalfd`.
+ *
+ * The signals are blocked on the calling thread and are read from the file
+ * descriptor instead of being delivered to a handler, i.e. a signal is
+ * processed by ordinary code of the control loop and nothing runs in
+ * signal context.
+ *
+ * The signals must be blocked on every thread of the process, otherwise
+ * the kernel may deliver a signal to a thread which has not blocked it and
+ * the default action of the signal applies.
+ * Hence, the receiver must be opened on the main thread before any other
+ * thread is started or every other thread must block all signals (as the
+ * background threads of this program do).
+ *
+ * The receiver does not wait itself; the owner adds the file descriptor to
+ * its wait set and calls `receive` if the descriptor becomes readable.
+ */
+class SignalReceiver {
+	public:
+		SignalReceiver();
+		SignalReceiver( SignalReceiver const& ) = delete;
+		SignalReceiver& operator=( SignalReceiver const& ) = delete;
+		~SignalReceiver();
+
+	public:
+		void open( std::initializer_list<int> const signals );
+		void close();
+		bool isOpen() const { return fd != -1; };
+		int getFd() const { return fd; };
+		int receive();
+
+	private:
+		int fd;
+		sigset_t previousMask;
+};
+
+}
+
+#endif
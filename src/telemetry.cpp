@@ -0,0 +1,71 @@
+#include "telemetry.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace AmdGpuFanControl {
+
+char const TelemetryRing::MAGIC[8] = { 'A', 'G', 'F', 'C', 'T', 'L', 'M', '\0' };
+std::uint32_t const TelemetryRing::VERSION( 1 );
+
+TelemetryRing::TelemetryRing() :
+	header( nullptr ),
+	records( nullptr ),
+	size( 0 ) {
+}
+
+TelemetryRing::~TelemetryRing() {
+	close();
+}
+
+/**
+ * Creates (or re-creates) the file and maps it into memory.
+ *
+ * Any previous content of the file is discarded.
+ * The pages are populated upfront such that recording a cycle does not
+ * trigger a page fault.
+ */
+void TelemetryRing::open( std::string const& filePath, std::uint64_t const capacity ) {
+	close();
+	if( capacity == 0 )
+		throw std::invalid_argument( "Telemetry ring needs at least one record" );
+
+	int const fd = ::open( filePath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644 );
+	if( fd == -1 )
+		throw std::system_error( errno, std::generic_category(), filePath );
+	size = getFileSize( capacity );
+	if( ftruncate( fd, size ) == -1 ) {
+		int const e = errno;
+		::close( fd );
+		throw std::system_error( e, std::generic_category(), filePath );
+	}
+	void* const p = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0 );
+	int const e = errno;
+	// The mapping stays valid after the file descriptor has been closed
+	::close( fd );
+	if( p == MAP_FAILED )
+		throw std::system_error( e, std::generic_category(), filePath );
+
+	header = static_cast<Header*>( p );
+	records = reinterpret_cast<Record*>( header + 1 );
+	std::memcpy( header->magic, MAGIC, sizeof( MAGIC ) );
+	header->version = VERSION;
+	header->recordSize = sizeof( Record );
+	header->capacity = capacity;
+	header->writeIndex.store( 0, std::memory_order_release );
+}
+
+void TelemetryRing::close() {
+	if( header == nullptr ) return;
+	munmap( header, size );
+	header = nullptr;
+	records = nullptr;
+	size = 0;
+}
+
+}
@@ -0,0 +1,145 @@
+#ifndef _TELEMETRY_H_
+#define _TELEMETRY_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include "types.h"
+
+namespace AmdGpuFanControl {
+
+/**
+ * Records every control cycle into a memory-mapped circular file.
+ *
+ * The file (typically below `/run`) consists of a `Header` followed by
+ * `capacity` fixed-size `Record`s.
+ * Each record occupies exactly one cache line.
+ * The daemon is the only writer: it fills in the next record and then
+ * publishes it by advancing `Header::writeIndex`.
+ * Hence, recording a cycle writes two cache lines (the record and the
+ * header) in the page cache and never calls `write`.
+ * Once the ring is full, the oldest records are overwritten.
+ *
+ * Readers (see `amdgpu-fanctrl-telemetry`) map the same file read-only.
+ * A reader may race with the writer.
+ * After a reader has copied record `i`, it re-reads `Header::writeIndex`
+ * behind an acquire fence;
+ * if the writer has meanwhile advanced to `i + capacity` or beyond, the
+ * record may have been overwritten while it was copied and is discarded.
+ */
+class TelemetryRing {
+	public:
+		static char const MAGIC[8];
+		static std::uint32_t const VERSION;
+
+		struct alignas(64) Header {
+			char magic[8];
+			std::uint32_t version;
+			std::uint32_t recordSize;
+			std::uint64_t capacity;
+			/**
+			 * Sequence number of the next record to be written, i.e. the number
+			 * of records which have been written in total.
+			 */
+			std::atomic<std::uint64_t> writeIndex;
+		};
+
+		struct alignas(64) Record {
+			std::uint64_t sequence;
+			std::uint64_t timestamp;  ///< CLOCK_MONOTONIC in ns
+			std::uint32_t controllerIdx;
+			std::uint32_t temperature;  ///< m°C
+			std::uint32_t calculatedPwmValue;
+			std::uint32_t pwmValue;
+			std::uint32_t readLatency;  ///< ns, see `toRecordLatency`
+			std::uint32_t writeLatency;  ///< ns, see `toRecordLatency`
+			std::uint8_t isUpdateNeeded;
+			std::uint8_t isSensorOk;
+		};
+
+		static_assert( sizeof( Header ) == 64, "Header must fill one cache line" );
+		static_assert( sizeof( Record ) == 64, "Record must fill one cache line" );
+		static_assert( std::atomic<std::uint64_t>::is_always_lock_free, "Header::writeIndex must be lock-free to be shared between processes" );
+
+	public:
+		TelemetryRing();
+		TelemetryRing( TelemetryRing const& ) = delete;
+		TelemetryRing& operator=( TelemetryRing const& ) = delete;
+		~TelemetryRing();
+
+	public:
+		/**
+		 * Converts a latency into nanoseconds for a record.
+		 *
+		 * Latencies beyond about 4.29 s (e.g. of a stuck sysfs read) are
+		 * saturated at the maximum instead of wrapping around.
+		 */
+		static std::uint32_t toRecordLatency( Latency const l ) {
+			Latency::rep const max = std::numeric_limits<std::uint32_t>::max();
+			return static_cast<std::uint32_t>( l.count() < max ? l.count() : max );
+		};
+
+	public:
+		void open( std::string const& filePath, std::uint64_t const capacity );
+		void close();
+		bool isOpen() const { return header != nullptr; };
+
+		/**
+		 * Returns the next record to be filled in.
+		 *
+		 * The record becomes visible to readers only after `commit`.
+		 * The new sequence number is stored before any other field, such
+		 * that a reader which sees a field of the recycled slot also sees
+		 * that the sequence number does not match anymore.
+		 */
+		Record& next() {
+			std::uint64_t const idx = header->writeIndex.load( std::memory_order_relaxed );
+			Record& r( records[idx % header->capacity] );
+			r.sequence = idx;
+			std::atomic_thread_fence( std::memory_order_release );
+			return r;
+		};
+
+		/**
+		 * Publishes the record which has been obtained by `next`.
+		 */
+		void commit() {
+			// There is only one writer, hence no atomic read-modify-write needed
+			header->writeIndex.store(
+				header->writeIndex.load( std::memory_order_relaxed ) + 1,
+				std::memory_order_release
+			);
+		};
+
+		/**
+		 * Returns the number of records which have been written in total.
+		 */
+		std::uint64_t getWriteIndex() const {
+			return header->writeIndex.load( std::memory_order_relaxed );
+		};
+		std::uint64_t getCapacity() const { return header->capacity; };
+		/**
+		 * Returns a record which has been written before, i.e. the sequence
+		 * number must be within the last `getCapacity` records.
+		 *
+		 * Only meant for the writer itself; other readers must map the file.
+		 */
+		Record const& getRecord( std::uint64_t const sequence ) const {
+			return records[sequence % header->capacity];
+		};
+
+		static std::size_t getFileSize( std::uint64_t const capacity ) {
+			return sizeof( Header ) + capacity * sizeof( Record );
+		};
+
+	private:
+		Header* header;
+		Record* records;
+		std::size_t size;
+};
+
+}
+
+#endif
@@ -0,0 +1,85 @@
+/**
+ * Dumps the telemetry ring of `amdgpu-fanctrl` as CSV.
+ *
+ * Usage: amdgpu-fanctrl-telemetry [<telemetry file>]
+ *
+ * The tool maps the file read-only and prints all records which are still
+ * in the ring from the oldest to the newest.
+ * It can safely be run while the daemon is writing the ring.
+ */
+
+#include "telemetry.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using AmdGpuFanControl::TelemetryRing;
+
+static char const* const DEFAULT_FILE_PATH = "/run/amdgpu-fanctrl.telemetry";
+
+int main( int argc, char* argv[] ) {
+	char const* const filePath = argc > 1 ? argv[1] : DEFAULT_FILE_PATH;
+
+	int const fd = open( filePath, O_RDONLY | O_CLOEXEC );
+	if( fd == -1 ) {
+		std::fprintf( stderr, "%s: %s\n", filePath, std::strerror( errno ) );
+		return EXIT_FAILURE;
+	}
+	struct stat st;
+	if( fstat( fd, &st ) == -1 || static_cast<std::size_t>( st.st_size ) < sizeof( TelemetryRing::Header ) ) {
+		std::fprintf( stderr, "%s: not a telemetry file\n", filePath );
+		return EXIT_FAILURE;
+	}
+	void const* const p = mmap( nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+	close( fd );
+	if( p == MAP_FAILED ) {
+		std::fprintf( stderr, "%s: %s\n", filePath, std::strerror( errno ) );
+		return EXIT_FAILURE;
+	}
+
+	TelemetryRing::Header const* const header = static_cast<TelemetryRing::Header const*>( p );
+	if(
+		std::memcmp( header->magic, TelemetryRing::MAGIC, sizeof( TelemetryRing::MAGIC ) ) != 0 ||
+		header->version != TelemetryRing::VERSION ||
+		header->recordSize != sizeof( TelemetryRing::Record ) ||
+		header->capacity == 0 ||
+		TelemetryRing::getFileSize( header->capacity ) > static_cast<std::size_t>( st.st_size )
+	) {
+		std::fprintf( stderr, "%s: unsupported telemetry file\n", filePath );
+		return EXIT_FAILURE;
+	}
+	TelemetryRing::Record const* const records = reinterpret_cast<TelemetryRing::Record const*>( header + 1 );
+	std::uint64_t const capacity = header->capacity;
+
+	std::printf( "sequence,timestamp_ns,controller,temperature_mC,sensor_ok,needs_update,calculated_pwm,written_pwm,read_latency_ns,write_latency_ns\n" );
+	std::uint64_t const end = header->writeIndex.load( std::memory_order_acquire );
+	for( std::uint64_t i = end > capacity ? end - capacity : 0; i != end; i++ ) {
+		TelemetryRing::Record const r( records[i % capacity] );
+		// Discard the record if the writer may have overwritten it meanwhile;
+		// the fence keeps the copy above from being reordered after the check
+		std::atomic_thread_fence( std::memory_order_acquire );
+		if( header->writeIndex.load( std::memory_order_acquire ) >= i + capacity ) continue;
+		if( r.sequence != i ) continue;
+		std::printf(
+			"%llu,%llu,%u,%u,%u,%u,%u,%u,%u,%u\n",
+			static_cast<unsigned long long>( r.sequence ),
+			static_cast<unsigned long long>( r.timestamp ),
+			r.controllerIdx,
+			r.temperature,
+			r.isSensorOk,
+			r.isUpdateNeeded,
+			r.calculatedPwmValue,
+			r.pwmValue,
+			r.readLatency,
+			r.writeLatency
+		);
+	}
+	return EXIT_SUCCESS;
+}
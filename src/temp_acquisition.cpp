@@ -0,0 +1,343 @@
+#include "temp_acquisition.h"
+#include "logger2.h"
+
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+#include <unistd.h>
+
+#if __has_include(<linux/io_uring.h>)
+#define HAVE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace AmdGpuFanControl {
+
+#ifdef HAVE_IO_URING
+
+/**
+ * Minimal wrapper around the raw io_uring syscall interface.
+ *
+ * The wrapper deliberately does not depend on `liburing` which is not
+ * available on our minimal images.
+ * It only supports what `TemperatureAcquisition` needs: queue reads at
+ * offset zero, submit them and reap the completions.
+ */
+class TemperatureAcquisition::IoUring {
+	public:
+		IoUring( unsigned const entries );
+		IoUring( IoUring const& ) = delete;
+		~IoUring() { release(); };
+
+	public:
+		bool isReadSupported() const;
+		void prepareRead( int const fd, char* buffer, unsigned const size, unsigned long const userData );
+		int enter( unsigned const toSubmit, unsigned const minComplete );
+		io_uring_cqe const* peekCompletion() const;
+		void advanceCompletion();
+
+	private:
+		void release();
+
+	private:
+		int fd;
+		void* sqRing;
+		std::size_t sqRingSize;
+		void* cqRing;
+		std::size_t cqRingSize;
+		io_uring_sqe* sqes;
+		std::size_t sqesSize;
+		unsigned* sqTail;
+		unsigned sqMask;
+		unsigned* sqArray;
+		unsigned* cqHead;
+		unsigned* cqTail;
+		unsigned cqMask;
+		io_uring_cqe* cqes;
+};
+
+TemperatureAcquisition::IoUring::IoUring( unsigned const entries ) :
+	fd( -1 ),
+	sqRing( MAP_FAILED ),
+	sqRingSize( 0 ),
+	cqRing( MAP_FAILED ),
+	cqRingSize( 0 ),
+	sqes( static_cast<io_uring_sqe*>( MAP_FAILED ) ),
+	sqesSize( 0 ) {
+	io_uring_params params;
+	std::memset( &params, 0, sizeof( params ) );
+	fd = syscall( __NR_io_uring_setup, entries, &params );
+	if( fd < 0 )
+		throw std::system_error( errno, std::generic_category(), "io_uring_setup" );
+
+	sqRingSize = params.sq_off.array + params.sq_entries * sizeof( unsigned );
+	cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof( io_uring_cqe );
+	bool const isSingleMMap = params.features & IORING_FEAT_SINGLE_MMAP;
+	if( isSingleMMap )
+		sqRingSize = cqRingSize = std::max( sqRingSize, cqRingSize );
+
+	sqRing = mmap( nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING );
+	if( sqRing == MAP_FAILED ) {
+		int const e = errno;
+		release();
+		throw std::system_error( e, std::generic_category(), "mmap of io_uring submission queue" );
+	}
+	if( isSingleMMap ) {
+		cqRing = sqRing;
+	} else {
+		cqRing = mmap( nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING );
+		if( cqRing == MAP_FAILED ) {
+			int const e = errno;
+			release();
+			throw std::system_error( e, std::generic_category(), "mmap of io_uring completion queue" );
+		}
+	}
+	sqesSize = params.sq_entries * sizeof( io_uring_sqe );
+	sqes = static_cast<io_uring_sqe*>( mmap( nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES ) );
+	if( sqes == MAP_FAILED ) {
+		int const e = errno;
+		release();
+		throw std::system_error( e, std::generic_category(), "mmap of io_uring submission entries" );
+	}
+
+	char* const sq = static_cast<char*>( sqRing );
+	char* const cq = static_cast<char*>( cqRing );
+	sqTail = reinterpret_cast<unsigned*>( sq + params.sq_off.tail );
+	sqMask = *reinterpret_cast<unsigned*>( sq + params.sq_off.ring_mask );
+	sqArray = reinterpret_cast<unsigned*>( sq + params.sq_off.array );
+	cqHead = reinterpret_cast<unsigned*>( cq + params.cq_off.head );
+	cqTail = reinterpret_cast<unsigned*>( cq + params.cq_off.tail );
+	cqMask = *reinterpret_cast<unsigned*>( cq + params.cq_off.ring_mask );
+	cqes = reinterpret_cast<io_uring_cqe*>( cq + params.cq_off.cqes );
+}
+
+void TemperatureAcquisition::IoUring::release() {
+	if( sqes != MAP_FAILED ) munmap( sqes, sqesSize );
+	if( cqRing != MAP_FAILED && cqRing != sqRing ) munmap( cqRing, cqRingSize );
+	if( sqRing != MAP_FAILED ) munmap( sqRing, sqRingSize );
+	if( fd != -1 ) close( fd );
+	sqes = static_cast<io_uring_sqe*>( MAP_FAILED );
+	cqRing = sqRing = MAP_FAILED;
+	fd = -1;
+}
+
+/**
+ * Asks the kernel whether it supports `IORING_OP_READ`.
+ *
+ * Kernels before 5.6 neither know the operation nor the probe.
+ */
+bool TemperatureAcquisition::IoUring::isReadSupported() const {
+	unsigned const opsLen = IORING_OP_READ + 1;
+	alignas( io_uring_probe ) unsigned char buffer[sizeof( io_uring_probe ) + opsLen * sizeof( io_uring_probe_op )];
+	std::memset( buffer, 0, sizeof( buffer ) );
+	io_uring_probe* const probe = reinterpret_cast<io_uring_probe*>( buffer );
+	if( syscall( __NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, opsLen ) < 0 )
+		return false;
+	return probe->ops_len > IORING_OP_READ && ( probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED );
+}
+
+/**
+ * Queues a read at offset zero.
+ *
+ * The caller must not queue more entries than the ring has been set up
+ * for before calling `enter`.
+ */
+void TemperatureAcquisition::IoUring::prepareRead(
+	int const fd, char* buffer, unsigned const size, unsigned long const userData
+) {
+	unsigned const tail = *sqTail;
+	unsigned const idx = tail & sqMask;
+	io_uring_sqe& sqe( sqes[idx] );
+	std::memset( &sqe, 0, sizeof( sqe ) );
+	sqe.opcode = IORING_OP_READ;
+	sqe.fd = fd;
+	sqe.addr = reinterpret_cast<unsigned long>( buffer );
+	sqe.len = size;
+	sqe.off = 0;
+	sqe.user_data = userData;
+	sqArray[idx] = idx;
+	// Publish the entry to the kernel only after it has been filled in
+	__atomic_store_n( sqTail, tail + 1, __ATOMIC_RELEASE );
+}
+
+/**
+ * Submits queued entries and waits for completions.
+ *
+ * The kernel only waits if all entries have been submitted.
+ *
+ * @return the number of submitted entries or a negative error number if
+ * no entry has been submitted
+ */
+int TemperatureAcquisition::IoUring::enter( unsigned const toSubmit, unsigned const minComplete ) {
+	long const result = syscall( __NR_io_uring_enter, fd, toSubmit, minComplete, IORING_ENTER_GETEVENTS, nullptr, 0 );
+	return result < 0 ? -errno : result;
+}
+
+io_uring_cqe const* TemperatureAcquisition::IoUring::peekCompletion() const {
+	unsigned const head = *cqHead;
+	if( head == __atomic_load_n( cqTail, __ATOMIC_ACQUIRE ) ) return nullptr;
+	return &cqes[head & cqMask];
+}
+
+void TemperatureAcquisition::IoUring::advanceCompletion() {
+	__atomic_store_n( cqHead, *cqHead + 1, __ATOMIC_RELEASE );
+}
+
+#else
+
+/**
+ * Placeholder if the kernel headers do not provide io_uring.
+ */
+class TemperatureAcquisition::IoUring {
+};
+
+#endif
+
+TemperatureAcquisition::TemperatureAcquisition() :
+	sensors(),
+	buffers(),
+	ring( nullptr ),
+	backend( Backend::PREAD ) {
+}
+
+TemperatureAcquisition::~TemperatureAcquisition() {
+	tearDownIoUring();
+}
+
+char const* TemperatureAcquisition::getBackendName( Backend const b ) {
+	switch( b ) {
+		case Backend::IO_URING:
+			return "io_uring";
+		case Backend::PREAD:
+		default:
+			return "pread";
+	}
+}
+
+/**
+ * Registers the sensors which are read by `acquire`.
+ *
+ * All buffers and the io_uring are allocated here, such that `acquire`
+ * itself does not allocate.
+ * If io_uring is requested, but the ring cannot be set up or the kernel
+ * does not support reads via io_uring, the acquisition falls back to
+ * `pread`.
+ */
+void TemperatureAcquisition::setSensors( SensorCollection const& s, Backend const requestedBackend ) {
+	LogStream& log( LogStream::get() );
+
+	tearDownIoUring();
+	sensors = s;
+	buffers.resize( sensors.size() );
+	backend = Backend::PREAD;
+
+#ifdef HAVE_IO_URING
+	if( requestedBackend == Backend::IO_URING && !sensors.empty() ) {
+		try {
+			ring = new IoUring( sensors.size() );
+			if( ring->isReadSupported() ) {
+				backend = Backend::IO_URING;
+			} else {
+				log << LogBuffer::Severity::NOTICE
+				    << "io_uring does not support reads on this kernel" << std::flush;
+				tearDownIoUring();
+			}
+		} catch( std::system_error const& e ) {
+			log << LogBuffer::Severity::NOTICE
+			    << "io_uring unavailable (" << e.what() << ")" << std::flush;
+		}
+	}
+#else
+	static_cast<void>( requestedBackend );
+#endif
+
+	log << LogBuffer::Severity::INFO
+	    << "Acquiring " << sensors.size() << " temperature sensor(s) via "
+	    << getBackendName( backend ) << std::flush;
+}
+
+void TemperatureAcquisition::acquire() {
+	if( backend == Backend::IO_URING )
+		acquireByIoUring();
+	else
+		acquireByPRead();
+}
+
+void TemperatureAcquisition::acquireByPRead() {
+	for( auto& sensor : sensors ) {
+		Clock::time_point const start = Clock::now();
+		sensor->getValue();
+		sensor->readLatency = Clock::now() - start;
+	}
+}
+
+/**
+ * Reads all sensors with a single `io_uring_enter` in the common case.
+ *
+ * A failed read only fails its sensor.
+ * Transient errors of `io_uring_enter` are retried; if it keeps failing,
+ * the reads which are still in flight are awaited, the sensors which have
+ * not been submitted are read by `pread` and the acquisition falls back to
+ * `pread` for good.
+ */
+void TemperatureAcquisition::acquireByIoUring() {
+#ifdef HAVE_IO_URING
+	unsigned const n = sensors.size();
+	Clock::time_point const start = Clock::now();
+	for( unsigned i = 0; i != n; i++ ) {
+		ring->prepareRead( sensors[i]->getFd(), buffers[i].data(), buffers[i].size(), i );
+	}
+
+	// Submit the whole batch and wait for all completions.
+	// If the wait is interrupted by a signal, the entries have nonetheless been
+	// submitted and we keep on waiting for the missing completions only.
+	unsigned submitted = 0;
+	unsigned completed = 0;
+	unsigned retries = 0;
+	int error = 0;
+	while( error == 0 ? completed != n : completed != submitted ) {
+		int const result = ring->enter( error == 0 ? n - submitted : 0, ( error == 0 ? n : submitted ) - completed );
+		if( result >= 0 ) {
+			submitted += result;
+		} else if( result == -EINTR || ( ( result == -EAGAIN || result == -EBUSY ) && ++retries <= MAX_ENTER_RETRIES ) ) {
+			// Transient, try again
+		} else if( error == 0 ) {
+			error = -result;
+		} else {
+			// Even waiting fails; the kernel cancels the reads in flight when
+			// the ring is torn down
+			break;
+		}
+		Latency const latency( Clock::now() - start );
+		for( io_uring_cqe const* cqe = ring->peekCompletion(); cqe != nullptr; cqe = ring->peekCompletion() ) {
+			sensors[cqe->user_data]->setRawValue( buffers[cqe->user_data].data(), cqe->res );
+			sensors[cqe->user_data]->readLatency = latency;
+			ring->advanceCompletion();
+			completed++;
+		}
+	}
+
+	if( error != 0 ) {
+		LogStream& log( LogStream::get() );
+		log << LogBuffer::Severity::WARNING
+		    << "io_uring submission failed (" << std::strerror( error ) << "); falling back to "
+		    << getBackendName( Backend::PREAD ) << std::flush;
+		tearDownIoUring();
+		backend = Backend::PREAD;
+		for( unsigned i = submitted; i != n; i++ ) {
+			Clock::time_point const readStart = Clock::now();
+			sensors[i]->getValue();
+			sensors[i]->readLatency = Clock::now() - readStart;
+		}
+	}
+#endif
+}
+
+void TemperatureAcquisition::tearDownIoUring() {
+	delete ring;
+	ring = nullptr;
+}
+
+}
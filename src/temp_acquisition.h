@@ -0,0 +1,81 @@
+#ifndef _TEMP_ACQUISITION_H_
+#define _TEMP_ACQUISITION_H_
+
+#include <array>
+#include <chrono>
+#include <vector>
+#include "temp_sensor.h"
+
+namespace AmdGpuFanControl {
+
+/**
+ * Reads all temperature sensors at once before the controllers run.
+ *
+ * Reading the sensors one by one serializes one blocking syscall per sensor
+ * and a single stalled read (e.g. while an amdgpu device wakes up from
+ * runtime power management) delays all following sensors.
+ * Instead, this class submits the reads for all registered sensors as
+ * a single batch to an io_uring and waits until all of them have completed.
+ * Hence, a cycle costs a single `io_uring_enter` independent of the number
+ * of sensors and stalled reads are handled concurrently by the kernel.
+ *
+ * On tmpfs, a single `pread` is an order of magnitude cheaper than the
+ * submission of a batch (see `amdgpu-read-test`), i.e. the io_uring only
+ * pays off for many sensors or slow drivers.
+ * Hence, the backend is chosen by the configuration and defaults to
+ * a loop of `pread`.
+ * If io_uring is requested, but not available (either not supported by
+ * the kernel headers at compile time, or not supported by the kernel or
+ * disabled by the administrator at runtime), the class falls back to
+ * `pread`.
+ *
+ * After `acquire` has returned, the values are available via
+ * `TemperatureSensor::getLastValue` and `TemperatureSensor::getStatus`.
+ */
+class TemperatureAcquisition {
+	public:
+		typedef std::vector<TemperatureSensor::Ptr> SensorCollection;
+		typedef std::array<char, TemperatureSensor::READ_BUFFER_SIZE> ReadBuffer;
+		typedef std::vector<ReadBuffer> ReadBufferCollection;
+		typedef std::chrono::steady_clock Clock;
+
+		enum Backend : unsigned short {
+			PREAD = 0,
+			IO_URING = 1
+		};
+
+	private:
+		class IoUring;
+
+		/**
+		 * Number of attempts to submit a batch after transient errors.
+		 */
+		static constexpr unsigned MAX_ENTER_RETRIES = 3;
+
+	public:
+		TemperatureAcquisition();
+		TemperatureAcquisition( TemperatureAcquisition const& ) = delete;
+		TemperatureAcquisition& operator=( TemperatureAcquisition const& ) = delete;
+		~TemperatureAcquisition();
+
+	public:
+		void setSensors( SensorCollection const& s, Backend const requestedBackend );
+		void acquire();
+		Backend getBackend() const { return backend; };
+		static char const* getBackendName( Backend const b );
+
+	private:
+		void acquireByPRead();
+		void acquireByIoUring();
+		void tearDownIoUring();
+
+	private:
+		SensorCollection sensors;
+		ReadBufferCollection buffers;
+		IoUring* ring;
+		Backend backend;
+};
+
+}
+
+#endif
@@ -0,0 +1,84 @@
+#include "temp_filter.h"
+
+#include <stdexcept>
+#include <string>
+
+namespace AmdGpuFanControl {
+
+/**
+ * C'tor.
+ *
+ * Only the settings of the enabled stages are validated.
+ *
+ * @throw std::invalid_argument if the window is not an odd number between
+ * 1 and `MAX_WINDOW`, if the shift exceeds `MAX_EMA_SHIFT` or if both
+ * stages together delay a step by more than `MAX_LAG` samples
+ */
+TemperatureFilter::TemperatureFilter( Mode const m, unsigned const window, unsigned const emaShift ) :
+	mode( m ),
+	windowSize( window ),
+	shift( emaShift ),
+	isPrimed( false ),
+	next( 0 ),
+	samples(),
+	average( 0 ) {
+	if( ( mode & Mode::MEDIAN ) && ( windowSize == 0 || windowSize > MAX_WINDOW || windowSize % 2 == 0 ) )
+		throw std::invalid_argument( "Median window must be an odd number of at most " + std::to_string( MAX_WINDOW ) + " samples" );
+	if( ( mode & Mode::EMA ) && shift > MAX_EMA_SHIFT )
+		throw std::invalid_argument( "EMA shift must not exceed " + std::to_string( MAX_EMA_SHIFT ) );
+	if( getLag() > MAX_LAG )
+		throw std::invalid_argument( "Filter delays a step by " + std::to_string( getLag() ) + " samples, at most " + std::to_string( MAX_LAG ) + " allowed" );
+}
+
+/**
+ * Returns the number of samples by which the enabled stages delay a step.
+ */
+unsigned TemperatureFilter::getLag() const {
+	unsigned lag = 0;
+	if( mode & Mode::MEDIAN ) lag += ( windowSize - 1 ) / 2;
+	if( mode & Mode::EMA ) lag += ( 1u << shift ) - 1;
+	return lag;
+}
+
+Temperature TemperatureFilter::apply( Temperature const t ) {
+	if( mode == Mode::NONE ) return t;
+	if( !isPrimed ) {
+		samples.fill( t );
+		average = static_cast<std::int64_t>( t ) << EMA_FRACTION_BITS;
+		isPrimed = true;
+	}
+
+	Temperature filtered = ( mode & Mode::MEDIAN ) ? median( t ) : t;
+	if( mode & Mode::EMA ) {
+		// Arithmetic shift of a signed value rounds towards negative infinity
+		// for both directions alike
+		average += ( ( static_cast<std::int64_t>( filtered ) << EMA_FRACTION_BITS ) - average ) >> shift;
+		filtered = static_cast<Temperature>(
+			( average + ( std::int64_t( 1 ) << ( EMA_FRACTION_BITS - 1 ) ) ) >> EMA_FRACTION_BITS
+		);
+	}
+	return filtered;
+}
+
+/**
+ * Stores the sample in the ring and returns the median of the window.
+ *
+ * The window is sorted by insertion into a copy, which is cheapest for at
+ * most `MAX_WINDOW` elements.
+ */
+Temperature TemperatureFilter::median( Temperature const t ) {
+	samples[next] = t;
+	next = ( next + 1 ) % windowSize;
+
+	std::array<Temperature, MAX_WINDOW> sorted;
+	for( unsigned i = 0; i != windowSize; i++ ) {
+		Temperature const v = samples[i];
+		unsigned j = i;
+		for( ; j != 0 && sorted[j - 1] > v; j-- )
+			sorted[j] = sorted[j - 1];
+		sorted[j] = v;
+	}
+	return sorted[windowSize / 2];
+}
+
+}
@@ -0,0 +1,77 @@
+#ifndef _TEMP_FILTER_H_
+#define _TEMP_FILTER_H_
+
+#include "types.h"
+#include <array>
+#include <cstdint>
+
+namespace AmdGpuFanControl {
+
+/**
+ * Smoothes the noise of temperature readings before they reach the
+ * control decision.
+ *
+ * The filter consists of two optional stages which are applied in this
+ * order:
+ *
+ *  - a median over a sliding window of the last `window` samples, which
+ *    removes single outliers entirely and delays a step by
+ *    `( window - 1 ) / 2` samples;
+ *  - an exponential moving average with a smoothing factor of
+ *    `1 / 2^emaShift`, which delays a step by `2^emaShift - 1` samples
+ *    (time constant).
+ *
+ * The filter must not delay a step by more than `MAX_LAG` samples in
+ * total, i.e. a median of 3 samples or a factor of 1/2 on their own.
+ * Hence, `MEDIAN_EMA` only fits if one of the stages is a pass-through
+ * (a window of 1 or a shift of 0); the median alone is the better choice
+ * for outliers, the average alone for uniform jitter.
+ *
+ * The state has a fixed size and the filter only uses integer arithmetic;
+ * the average keeps `EMA_FRACTION_BITS` fractional bits such that it
+ * converges to the input instead of stalling up to `2^emaShift` m°C below
+ * or above.
+ * The first sample initializes the entire state.
+ */
+class TemperatureFilter {
+	public:
+		/**
+		 * The stages are bits such that `MEDIAN_EMA` combines both.
+		 */
+		enum Mode : unsigned short {
+			NONE = 0,
+			EMA = 1,
+			MEDIAN = 2,
+			MEDIAN_EMA = 3
+		};
+
+		static constexpr unsigned MAX_LAG = 1;
+		static constexpr unsigned MAX_WINDOW = 2 * MAX_LAG + 1;
+		static constexpr unsigned MAX_EMA_SHIFT = 1;
+		static constexpr unsigned EMA_FRACTION_BITS = 8;
+
+	public:
+		TemperatureFilter( Mode const m, unsigned const window, unsigned const emaShift );
+
+	public:
+		Temperature apply( Temperature const t );
+		Mode getMode() const { return mode; };
+
+		unsigned getLag() const;
+
+	private:
+		Temperature median( Temperature const t );
+
+	private:
+		Mode mode;
+		unsigned windowSize;
+		unsigned shift;
+		bool isPrimed;
+		unsigned next;
+		std::array<Temperature, MAX_WINDOW> samples;
+		std::int64_t average;
+};
+
+}
+
+#endif
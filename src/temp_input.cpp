@@ -0,0 +1,122 @@
+#include "temp_input.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+namespace AmdGpuFanControl {
+
+/**
+ * Creates the input of a single sensor.
+ */
+TemperatureInput::TemperatureInput( TemperatureSensor::Ptr const& sensor ) :
+	sensors( 1, sensor ),
+	aggregation( Aggregation::MAX ),
+	weights( 1, 1 ),
+	limits( 1, 0 ) {
+}
+
+/**
+ * Creates the input of several sensors.
+ *
+ * Without weights, all sensors are weighted equally.
+ * Without limits, the critical temperature of each sensor is read from the
+ * hwmon attribute of the same channel (e.g. `temp3_crit`).
+ *
+ * @throw std::invalid_argument if there is no sensor, if the number of
+ * weights or limits does not match the number of sensors, if all weights
+ * are zero or if a limit is unknown for `MARGIN`
+ */
+TemperatureInput::TemperatureInput(
+	SensorSeq const& s,
+	Aggregation const a,
+	WeightSeq const& w,
+	LimitSeq const& l
+) :
+	sensors( s ),
+	aggregation( a ),
+	weights( w ),
+	limits( l ) {
+	if( sensors.empty() )
+		throw std::invalid_argument( "No temperature sensor" );
+	if( weights.empty() )
+		weights.assign( sensors.size(), 1 );
+	if( weights.size() != sensors.size() )
+		throw std::invalid_argument( "Number of weights does not match number of sensors" );
+	if( std::all_of( weights.begin(), weights.end(), []( unsigned long const weight ) { return weight == 0; } ) )
+		throw std::invalid_argument( "All weights are zero" );
+
+	if( limits.empty() ) {
+		for( auto const& sensor : sensors )
+			limits.push_back( sensor->readCriticalValue() );
+	}
+	if( limits.size() != sensors.size() )
+		throw std::invalid_argument( "Number of limits does not match number of sensors" );
+	if( aggregation == Aggregation::MARGIN && std::find( limits.begin(), limits.end(), 0 ) != limits.end() )
+		throw std::invalid_argument( "Unknown limit of temperature sensor" );
+}
+
+/**
+ * Computes the aggregated temperature of all sensors which have been read
+ * successfully.
+ *
+ * @return `false` if no sensor has been read successfully and `t` is left
+ * untouched; `true` otherwise
+ */
+bool TemperatureInput::aggregate( Temperature& t ) const {
+	std::uint64_t result = 0;
+	std::uint64_t weightSum = 0;
+	bool isAnyOk = false;
+	for( SensorSeq::size_type i = 0; i != sensors.size(); i++ ) {
+		TemperatureSensor const& sensor( *sensors[i] );
+		if( sensor.getStatus() != TemperatureSensor::Status::OK ) continue;
+		std::uint64_t const value = sensor.getLastValue();
+		switch( aggregation ) {
+			case Aggregation::MAX:
+				result = std::max( result, value );
+				break;
+			case Aggregation::WEIGHTED:
+				result += weights[i] * value;
+				weightSum += weights[i];
+				break;
+			case Aggregation::MARGIN:
+				result = std::max( result, value * limits.front() / limits[i] );
+				break;
+		}
+		isAnyOk = true;
+	}
+	if( !isAnyOk ) return false;
+	if( aggregation == Aggregation::WEIGHTED ) {
+		// Only zero weights among the sensors which have been read
+		// successfully; fall back to the maximum
+		if( weightSum == 0 ) {
+			for( auto const& sensor : sensors ) {
+				if( sensor->getStatus() == TemperatureSensor::Status::OK )
+					result = std::max<std::uint64_t>( result, sensor->getLastValue() );
+			}
+		} else {
+			result /= weightSum;
+		}
+	}
+	t = static_cast<Temperature>( std::min<std::uint64_t>( result, std::numeric_limits<Temperature>::max() ) );
+	return true;
+}
+
+bool TemperatureInput::isOk() const {
+	return std::any_of( sensors.begin(), sensors.end(), []( TemperatureSensor::Ptr const& sensor ) {
+		return sensor->getStatus() == TemperatureSensor::Status::OK;
+	} );
+}
+
+/**
+ * Returns the highest read latency of all sensors.
+ */
+Latency TemperatureInput::getReadLatency() const {
+	Latency latency( Latency::zero() );
+	for( auto const& sensor : sensors )
+		latency = std::max( latency, sensor->getReadLatency() );
+	return latency;
+}
+
+}
@@ -0,0 +1,78 @@
+#ifndef _TEMP_INPUT_H_
+#define _TEMP_INPUT_H_
+
+#include "temp_sensor.h"
+#include "types.h"
+#include <vector>
+
+namespace AmdGpuFanControl {
+
+/**
+ * Aggregates the readings of one or more sensors into the input
+ * temperature of a controller.
+ *
+ * E.g., amdgpu exposes the edge, junction and memory temperature as
+ * separate channels and boards with HBM throttle on the memory temperature
+ * while the edge temperature is still moderate.
+ *
+ * The input does not read the sensors itself, but aggregates the values
+ * which `TemperatureAcquisition` has acquired for all sensors in a single
+ * pass.
+ * Sensors whose most recent reading has failed are left out; the input
+ * fails only if all sensors have failed.
+ *
+ * The aggregation is one of
+ *
+ *  - `MAX`: the highest temperature;
+ *  - `WEIGHTED`: the weighted average;
+ *  - `MARGIN`: the sensor which is closest to its limit relative to the
+ *    limit, i.e. the maximum of `t_i / limit_i`, scaled to the limit of
+ *    the first sensor.
+ *    Hence, the fan curve of the controller is defined in terms of the
+ *    first sensor and the other sensors take over as soon as they are
+ *    relatively closer to their limit.
+ *
+ * All arithmetic is integer.
+ */
+class TemperatureInput {
+	public:
+		typedef std::vector<TemperatureSensor::Ptr> SensorSeq;
+		typedef std::vector<unsigned long> WeightSeq;
+		typedef std::vector<Temperature> LimitSeq;
+
+		enum Aggregation : unsigned short {
+			MAX = 0,
+			WEIGHTED = 1,
+			MARGIN = 2
+		};
+
+	public:
+		explicit TemperatureInput( TemperatureSensor::Ptr const& sensor );
+		TemperatureInput(
+			SensorSeq const& s,
+			Aggregation const a,
+			WeightSeq const& w,
+			LimitSeq const& l
+		);
+
+	public:
+		bool aggregate( Temperature& t ) const;
+		/**
+		 * Indicates whether the most recent reading of at least one sensor has
+		 * succeeded.
+		 */
+		bool isOk() const;
+		Latency getReadLatency() const;
+		SensorSeq const& getSensors() const { return sensors; };
+		Aggregation getAggregation() const { return aggregation; };
+
+	private:
+		SensorSeq sensors;
+		Aggregation aggregation;
+		WeightSeq weights;
+		LimitSeq limits;
+};
+
+}
+
+#endif
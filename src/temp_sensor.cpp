@@ -1,18 +1,176 @@
 #include "temp_sensor.h"
 
+#include <cerrno>
+#include <limits>
+#include <system_error>
+#include <fcntl.h>
+#include <unistd.h>
+
 namespace AmdGpuFanControl {
 
+char const* const TemperatureSensor::INPUT_FILE_SUFFIX = "_input";
+char const* const TemperatureSensor::CRITICAL_FILE_SUFFIX = "_crit";
+char const* const TemperatureSensor::ALARM_FILE_SUFFIXES[] = {
+	"_alarm",
+	"_max_alarm",
+	"_crit_alarm",
+	"_emergency_alarm",
+	nullptr
+};
+
 TemperatureSensor::TemperatureSensor( std::string const& devFilePath ) :
-	fileStream() {
-	fileStream.exceptions( std::ofstream::failbit | std::ofstream::badbit );
-	fileStream.open( devFilePath );
+	filePath( devFilePath ),
+	fd( -1 ),
+	value( 0 ),
+	status( Status::OK ),
+	readLatency( 0 ),
+	alarmFds() {
+	fd = open( devFilePath.c_str(), O_RDONLY | O_CLOEXEC );
+	if( fd == -1 )
+		throw std::system_error( errno, std::generic_category(), devFilePath );
+}
+
+TemperatureSensor::TemperatureSensor( TemperatureSensor&& other ) :
+	filePath( std::move( other.filePath ) ),
+	fd( other.fd ),
+	value( other.value ),
+	status( other.status ),
+	readLatency( other.readLatency ),
+	alarmFds( std::move( other.alarmFds ) ) {
+	other.fd = -1;
+	other.alarmFds.clear();
+}
+
+TemperatureSensor::~TemperatureSensor() {
+	if( fd != -1 ) close( fd );
+	for( int const alarmFd : alarmFds ) close( alarmFd );
 }
 
+/**
+ * Opens the alarm attributes which belong to the same channel as the input.
+ *
+ * Attributes which do not exist are silently skipped, as the set of
+ * supported alarms depends on the driver.
+ * Each opened attribute is read once, because sysfs only notifies changes
+ * of an attribute after it has been read.
+ *
+ * @return the number of opened alarm attributes
+ */
+TemperatureSensor::AlarmFdCollection::size_type TemperatureSensor::openAlarms() {
+	std::string::size_type const suffixLength = std::char_traits<char>::length( INPUT_FILE_SUFFIX );
+	if(
+		!alarmFds.empty() ||
+		filePath.size() < suffixLength ||
+		filePath.compare( filePath.size() - suffixLength, suffixLength, INPUT_FILE_SUFFIX ) != 0
+	) return alarmFds.size();
+
+	std::string const prefix( filePath, 0, filePath.size() - suffixLength );
+	for( char const* const* suffix = ALARM_FILE_SUFFIXES; *suffix != nullptr; ++suffix ) {
+		std::string const alarmFilePath( prefix + *suffix );
+		int const alarmFd = open( alarmFilePath.c_str(), O_RDONLY | O_CLOEXEC );
+		if( alarmFd == -1 ) continue;
+		char buffer[READ_BUFFER_SIZE];
+		if( pread( alarmFd, buffer, READ_BUFFER_SIZE, 0 ) < 0 ) {
+			close( alarmFd );
+			continue;
+		}
+		alarmFds.push_back( alarmFd );
+	}
+	return alarmFds.size();
+}
+
+/**
+ * Reads the critical temperature of the same channel as the input (e.g.
+ * `temp2_crit` for `temp2_input`).
+ *
+ * This is not meant for the control loop, but for the configuration of a
+ * controller at start-up.
+ *
+ * @return the critical temperature or zero if the attribute does not exist
+ * or cannot be read
+ */
+Temperature TemperatureSensor::readCriticalValue() const {
+	std::string::size_type const suffixLength = std::char_traits<char>::length( INPUT_FILE_SUFFIX );
+	if(
+		filePath.size() < suffixLength ||
+		filePath.compare( filePath.size() - suffixLength, suffixLength, INPUT_FILE_SUFFIX ) != 0
+	) return 0;
+
+	std::string const critFilePath( std::string( filePath, 0, filePath.size() - suffixLength ) + CRITICAL_FILE_SUFFIX );
+	int const critFd = open( critFilePath.c_str(), O_RDONLY | O_CLOEXEC );
+	if( critFd == -1 ) return 0;
+	char buffer[READ_BUFFER_SIZE];
+	long const n = pread( critFd, buffer, READ_BUFFER_SIZE, 0 );
+	close( critFd );
+	Temperature t = 0;
+	if( n <= 0 || parseValue( buffer, buffer + n, t ) != Status::OK ) return 0;
+	return t;
+}
+
+/**
+ * Reads the current temperature from the device file.
+ *
+ * @internal sysfs attributes are regenerated on every read from offset zero,
+ * hence a single `pread` at offset zero returns the current value and no
+ * separate `lseek` is required.
+ */
 Temperature TemperatureSensor::getValue() {
+	char buffer[READ_BUFFER_SIZE];
+	setRawValue( buffer, pread( fd, buffer, READ_BUFFER_SIZE, 0 ) );
+	return value;
+}
+
+/**
+ * Updates the value and status from the result of a read.
+ *
+ * @param buffer the buffer which has been read into
+ * @param n the number of bytes read or a negative number if the read has
+ * failed
+ */
+void TemperatureSensor::setRawValue( char const* buffer, long n ) {
+	if( n <= 0 ) {
+		status = Status::IO_ERROR;
+		return;
+	}
+
 	Temperature t;
-	fileStream.seekg(0);
-	fileStream >> t;
-	return t;
+	status = parseValue( buffer, buffer + n, t );
+	if( status == Status::OK ) value = t;
+}
+
+/**
+ * Parses a decimal temperature in millidegree Celsius.
+ *
+ * Leading and trailing whitespace (in particular, the terminating newline)
+ * is ignored.
+ * As `Temperature` is unsigned, a negative reading is clamped to zero.
+ * Any other character or a value which does not fit into `Temperature`
+ * yields `PARSE_ERROR` and leaves `t` untouched.
+ */
+TemperatureSensor::Status TemperatureSensor::parseValue(
+	char const* begin, char const* end, Temperature& t
+) {
+	char const* p = begin;
+	while( p != end && ( *p == ' ' || *p == '\t' ) ) ++p;
+
+	bool const isNegative = ( p != end && *p == '-' );
+	if( isNegative ) ++p;
+
+	char const* const digits = p;
+	Temperature result = 0;
+	for( ; p != end && *p >= '0' && *p <= '9'; ++p ) {
+		Temperature const digit = *p - '0';
+		if( result > ( std::numeric_limits<Temperature>::max() - digit ) / 10 )
+			return Status::PARSE_ERROR;
+		result = 10 * result + digit;
+	}
+	if( p == digits ) return Status::PARSE_ERROR;
+
+	while( p != end && ( *p == ' ' || *p == '\t' || *p == '\n' ) ) ++p;
+	if( p != end ) return Status::PARSE_ERROR;
+
+	t = isNegative ? 0 : result;
+	return Status::OK;
 }
 
 }
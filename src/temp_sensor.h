@@ -1,30 +1,102 @@
 #ifndef _TEMP_SENSOR_H_
 #define _TEMP_SENSOR_H_
 
-#include <fstream>
+#include <cstddef>
 #include <memory>
+#include <string>
+#include <vector>
 #include "types.h"
 
 namespace AmdGpuFanControl {
 
 class TemperatureSensorFactory;
+class TemperatureAcquisition;
 
+/**
+ * Reads the temperature from a hwmon `temp*_input` file.
+ *
+ * The class keeps a raw file descriptor open for its entire lifetime.
+ * Every call to `getValue` issues exactly one `pread` at offset zero into a
+ * small buffer on the stack and parses the millidegree integer by hand.
+ * Hence, reading a sensor neither allocates memory nor involves the
+ * locale-aware formatting machinery of `std::istream`.
+ *
+ * Read errors do not throw, but are reported by `getStatus`.
+ * If the most recent read has failed, `getValue` returns the last value
+ * which has been read successfully.
+ *
+ * Within the control loop, sensors are not read one by one, but all at once
+ * by `TemperatureAcquisition`, which hands the raw buffers back to the sensor.
+ * Afterwards, the acquired value is available via `getLastValue`.
+ *
+ * Optionally, the sensor opens the alarm attributes of the same channel
+ * (e.g. `temp1_crit_alarm` for `temp1_input`), see `openAlarms`.
+ * The kernel notifies changes of these attributes via `poll` with
+ * `POLLPRI`, which allows the control loop to wake up immediately when a
+ * threshold is crossed.
+ */
 class TemperatureSensor {
 	friend class TemperatureSensorFactory;
+	friend class TemperatureAcquisition;
 
 	public:
 		typedef std::shared_ptr<TemperatureSensor> Ptr;
+		typedef std::vector<int> AlarmFdCollection;
+
+		enum Status : unsigned short {
+			OK = 0,
+			IO_ERROR = 1,
+			PARSE_ERROR = 2
+		};
+
+		/**
+		 * Size of the read buffer on the stack.
+		 *
+		 * The kernel formats a hwmon temperature as a signed decimal integer
+		 * in millidegree Celsius followed by a newline, i.e. some few characters
+		 * suffice.
+		 */
+		static constexpr std::size_t READ_BUFFER_SIZE = 32;
+
+		static char const* const INPUT_FILE_SUFFIX;
+		static char const* const CRITICAL_FILE_SUFFIX;
+		static char const* const ALARM_FILE_SUFFIXES[];
 
 	protected:
 		TemperatureSensor( std::string const& devFilePath );
 		TemperatureSensor( TemperatureSensor const& ) = delete;
 
 	public:
-		TemperatureSensor( TemperatureSensor&& other ) : fileStream( std::move( other.fileStream ) ) {};
+		TemperatureSensor( TemperatureSensor&& other );
+		virtual ~TemperatureSensor();
 		Temperature getValue();
+		Temperature getLastValue() const { return value; };
+		Status getStatus() const { return status; };
+		/**
+		 * Returns how long the most recent acquisition of this sensor took.
+		 *
+		 * If the sensor has been read as part of a batch, this is the latency
+		 * of the batch.
+		 */
+		Latency getReadLatency() const { return readLatency; };
+		std::string const& getFilePath() const { return filePath; };
+		AlarmFdCollection::size_type openAlarms();
+		AlarmFdCollection const& getAlarmFds() const { return alarmFds; };
+		Temperature readCriticalValue() const;
+
+		static Status parseValue( char const* begin, char const* end, Temperature& t );
+
+	private:
+		int getFd() const { return fd; };
+		void setRawValue( char const* buffer, long n );
 
 	private:
-		std::ifstream fileStream;
+		std::string filePath;
+		int fd;
+		Temperature value;
+		Status status;
+		Latency readLatency;
+		AlarmFdCollection alarmFds;
 };
 }
 
@@ -8,6 +8,7 @@ namespace AmdGpuFanControl {
 typedef unsigned int Temperature;
 typedef unsigned int PwmValue;
 typedef std::chrono::milliseconds Duration;
+typedef std::chrono::nanoseconds Latency;
 
 struct ControlPoint {
 	Temperature temp;